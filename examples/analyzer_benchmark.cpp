@@ -0,0 +1,97 @@
+/* Copyright (c) 2022  Hunter Whyte */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "jumaudio.hpp"
+
+// times jum_analyze against the compile-time sized jum::Analyzer on the same pushed noise, and
+// checks both give the same output
+
+#define SAMPLE_RATE 48000
+#define FFT_BUF_SIZE 4096
+#define NUM_BINS 256
+#define FRAME_MS 16
+#define FRAME_SAMPLES (SAMPLE_RATE * FRAME_MS / 1000)
+#define NUM_FRAMES 2000
+
+#define NUM_WEIGHTS 15
+const float weights[NUM_WEIGHTS][2] = {{63, -5},    {200, -5},   {250, -5},   {315, -5},
+                                       {400, -4.8}, {500, -3.2}, {630, -1.9}, {800, -0.8},
+                                       {1000, 0.0}, {1250, 0.6}, {1600, 1.0}, {2000, 1.2},
+                                       {2500, 3.3}, {3150, 4.2}, {4000, 5.0}};
+
+#define NUM_FREQS 10
+const float freqs[NUM_FREQS][2] = {{0, 35},      {0.2, 450},  {0.3, 700},  {0.4, 1200},
+                                   {0.5, 1700},  {0.6, 2600}, {0.7, 4100}, {0.8, 6500},
+                                   {0.9, 10000}, {1.0, 20000}};
+
+double nowUs() {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// push a frame of xorshift noise, never gated so both paths do the full pipeline every frame
+void pushNoise(jum_AudioSetup* audio, ma_uint32* seed) {
+  float frames[FRAME_SAMPLES * 2];
+  for (ma_int32 i = 0; i < FRAME_SAMPLES; i++) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    frames[i * 2] = 0.5F * ((float)*seed / 4294967295.0F * 2 - 1);
+    frames[i * 2 + 1] = frames[i * 2];
+  }
+  jum_pushSamples(audio, frames, FRAME_SAMPLES, ma_format_f32, 2, -1);
+}
+
+int main() {
+  jum_AudioSetup* audio;
+  jum_FFTSetup* fft;
+  ma_uint32 seed = 12345;
+  double start, c_us = 0, cpp_us = 0;
+  float diff = 0;
+
+  audio = jum_initAudio(FFT_BUF_SIZE * 8, 1, FRAME_SAMPLES);
+  if (audio == NULL) {
+    printf("failed to initialize audio\n");
+    return 1;
+  }
+  jum_openPushInput(audio, SAMPLE_RATE);
+  fft = jum_initFFT(freqs, NUM_FREQS, weights, NUM_WEIGHTS, FFT_BUF_SIZE, NUM_BINS);
+  jum::Analyzer<FFT_BUF_SIZE, NUM_BINS, 2> analyzer(freqs, weights);
+  if (fft == NULL || !analyzer) {
+    printf("failed to initialize fft\n");
+    return 1;
+  }
+  printf("fft backend: %s\n", jum_getFFTBackendName(fft));
+
+  // fill the buffer first so the C path's silence gate doesn't see the empty start
+  for (ma_int32 n = 0; n < 1000 / FRAME_MS; n++) {
+    pushNoise(audio, &seed);
+  }
+  for (ma_int32 n = 0; n < NUM_FRAMES; n++) {
+    pushNoise(audio, &seed);
+
+    start = nowUs();
+    jum_analyze(fft, audio, FRAME_MS);
+    c_us += nowUs() - start;
+    start = nowUs();
+    analyzer.analyze(*audio, FRAME_MS);
+    cpp_us += nowUs() - start;
+
+    auto result = analyzer.result();
+    for (ma_int32 i = 0; i < NUM_BINS; i++) {
+      diff = fmaxf(diff, fabsf(result[i] - fft->result[i]));
+    }
+  }
+
+  printf("jum_analyze       %.1f us per frame\n", c_us / NUM_FRAMES);
+  printf("jum::Analyzer     %.1f us per frame (%.2fx)\n", cpp_us / NUM_FRAMES, c_us / cpp_us);
+  printf("max difference    %g\n", diff);
+
+  jum_deinitFFT(fft);
+  jum_deinitAudio(audio);
+  return diff > 1e-6F;
+}
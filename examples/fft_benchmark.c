@@ -0,0 +1,84 @@
+/* Copyright (c) 2022  Hunter Whyte */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "jumaudio.h"
+
+#define MIN_FFT_SIZE 32
+#define MAX_FFT_SIZE 16384
+// roughly how many samples to push through each backend per size
+#define SAMPLES_PER_RUN (1 << 26)
+
+double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// compare every supported backend against pffft for each power of 2 size
+int main(void) {
+  float *in, *out, *expected, *work;
+  void *setup, *reference;
+  const FFTBackend* backend;
+  ma_int32 size, b, i, runs, run;
+  float err, peak;
+  double start, ns, pffft_ns;
+
+  in = pffft_aligned_malloc(MAX_FFT_SIZE * sizeof(float));
+  out = pffft_aligned_malloc(MAX_FFT_SIZE * sizeof(float));
+  expected = pffft_aligned_malloc(MAX_FFT_SIZE * sizeof(float));
+  work = pffft_aligned_malloc(MAX_FFT_SIZE * sizeof(float));
+
+  printf("%-8s %-8s %12s %10s %12s\n", "size", "backend", "ns/fft", "speedup", "max error");
+  for (size = MIN_FFT_SIZE; size <= MAX_FFT_SIZE; size *= 2) {
+    for (i = 0; i < size; i++) {
+      in[i] = (float)rand() / RAND_MAX * 2 - 1;
+    }
+    reference = jum_pffft_backend.create(size);
+    jum_pffft_backend.transform(reference, in, expected, work);
+    runs = SAMPLES_PER_RUN / size;
+    start = nowNs();
+    for (run = 0; run < runs; run++) {
+      jum_pffft_backend.transform(reference, in, out, work);
+    }
+    pffft_ns = (nowNs() - start) / runs;
+    jum_pffft_backend.destroy(reference);
+    peak = 0;
+    for (i = 0; i < size; i++) {
+      peak = fabsf(expected[i]) > peak ? fabsf(expected[i]) : peak;
+    }
+
+    for (b = 0; b < jum_num_fft_backends; b++) {
+      backend = jum_fft_backends[b];
+      if (!backend->supported() || (setup = backend->create(size)) == NULL) {
+        printf("%-8d %-8s %12s\n", size, backend->name, "unsupported");
+        continue;
+      }
+
+      backend->transform(setup, in, out, work);
+      err = 0;
+      for (i = 0; i < size; i++) {
+        err = fabsf(out[i] - expected[i]) > err ? fabsf(out[i] - expected[i]) : err;
+      }
+
+      start = nowNs();
+      for (run = 0; run < runs; run++) {
+        backend->transform(setup, in, out, work);
+      }
+      ns = (nowNs() - start) / runs;
+      // speedup over pffft at this size, error relative to the largest output so sizes compare
+      printf("%-8d %-8s %12.1f %9.2fx %12.2e\n", size, backend->name, ns,
+             pffft_ns / ns, err / peak);
+      backend->destroy(setup);
+    }
+  }
+
+  pffft_aligned_free(in);
+  pffft_aligned_free(out);
+  pffft_aligned_free(expected);
+  pffft_aligned_free(work);
+  return 0;
+}
@@ -0,0 +1,438 @@
+/* Copyright (c) 2022  Hunter Whyte */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jumaudio.h"
+
+// headless end to end run of the library on synthetic signals, fed through the push input so no
+// device or SDL is needed. exits non-zero if any functional check fails. timings depend on the
+// machine so they are only checked when limits are given:
+//   ./regression --max-push-us 50 --max-analyze-us 200 --min-realtime 20
+// ./regression --write-reference > regression_reference.h regenerates the reference outputs after
+// an intended change to the analysis
+
+#define SAMPLE_RATE 48000
+#define FFT_BUF_SIZE 4096
+#define NUM_BINS 256
+#define FRAME_MS 16  // jum_analyze rate of a 60fps render loop
+#define FRAME_SAMPLES (SAMPLE_RATE * FRAME_MS / 1000)
+
+#define MAX_LATENCY_MS 150.0  // tone onset until its bin reaches half scale, in audio time
+#define MAX_S16_DIFF 0.005    // largest result difference between f32 and s16 audio buffers
+#define MAX_REFERENCE_DIFF 0.01  // largest result difference from regression_reference.h
+
+#define NUM_WEIGHTS 15
+const float weights[NUM_WEIGHTS][2] = {{63, -5},    {200, -5},   {250, -5},   {315, -5},
+                                       {400, -4.8}, {500, -3.2}, {630, -1.9}, {800, -0.8},
+                                       {1000, 0.0}, {1250, 0.6}, {1600, 1.0}, {2000, 1.2},
+                                       {2500, 3.3}, {3150, 4.2}, {4000, 5.0}};
+
+#define NUM_FREQS 10
+const float freqs[NUM_FREQS][2] = {{0, 35},      {0.2, 450},  {0.3, 700},  {0.4, 1200},
+                                   {0.5, 1700},  {0.6, 2600}, {0.7, 4100}, {0.8, 6500},
+                                   {0.9, 10000}, {1.0, 20000}};
+
+typedef enum { SIGNAL_SILENCE, SIGNAL_TONE, SIGNAL_SWEEP, SIGNAL_NOISE } SignalType;
+
+typedef struct signal {
+  SignalType type;
+  double freq;      // tone frequency, or sweep start
+  double freq_end;  // sweep end
+  double seconds;   // sweep length
+  ma_uint32 seed;   // noise state
+  ma_uint64 n;      // next sample index
+} Signal;
+
+// signal whose final output is compared against regression_reference.h, run into a fresh setup
+typedef struct reference {
+  const char* name;
+  Signal signal;
+  double seconds;
+} Reference;
+
+typedef struct stats {
+  double push_ns, analyze_ns, max_push_ns, max_analyze_ns;
+  ma_uint64 frames;
+} Stats;
+
+ma_int32 failures = 0;
+Stats stats;
+
+#include "regression_reference.h"
+
+const Reference references[NUM_REFERENCES] = {
+    {"tone", {SIGNAL_TONE, 440, 0, 0, 0, 0}, 1},
+    {"sweep", {SIGNAL_SWEEP, 100, 10000, 2, 0, 0}, 2},
+    {"noise", {SIGNAL_NOISE, 0, 0, 0, 777, 0}, 1},
+};
+
+double nowNs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void check(bool ok, const char* what) {
+  printf("%-6s %s\n", ok ? "ok" : "FAIL", what);
+  if (!ok) {
+    failures++;
+  }
+}
+
+float nextSample(Signal* signal) {
+  double t = (double)signal->n++ / SAMPLE_RATE;
+  double k;
+
+  switch (signal->type) {
+    case SIGNAL_TONE:
+      return 0.5F * sin(2 * M_PI * signal->freq * t);
+    case SIGNAL_SWEEP:
+      // exponential sine sweep, same as the README demo
+      k = log(signal->freq_end / signal->freq);
+      return 0.5F * sin(2 * M_PI * signal->freq * signal->seconds / k *
+                        (exp(t / signal->seconds * k) - 1));
+    case SIGNAL_NOISE:
+      // xorshift so every run sees the same noise
+      signal->seed ^= signal->seed << 13;
+      signal->seed ^= signal->seed >> 17;
+      signal->seed ^= signal->seed << 5;
+      return 0.5F * ((float)signal->seed / 4294967295.0F * 2 - 1);
+    default:
+      return 0;
+  }
+}
+
+// push one frame's worth of the signal and analyze it, timing both
+void step(jum_AudioSetup* audio, jum_FFTSetup* fft, Signal* signal) {
+  float frames[FRAME_SAMPLES * 2];
+  double start, ns;
+  ma_int32 i;
+
+  for (i = 0; i < FRAME_SAMPLES; i++) {
+    frames[i * 2] = nextSample(signal);
+    frames[i * 2 + 1] = frames[i * 2];
+  }
+  start = nowNs();
+  jum_pushSamples(audio, frames, FRAME_SAMPLES, ma_format_f32, 2, -1);
+  ns = nowNs() - start;
+  stats.push_ns += ns;
+  stats.max_push_ns = ns > stats.max_push_ns ? ns : stats.max_push_ns;
+
+  start = nowNs();
+  jum_analyze(fft, audio, FRAME_MS);
+  ns = nowNs() - start;
+  stats.analyze_ns += ns;
+  stats.max_analyze_ns = ns > stats.max_analyze_ns ? ns : stats.max_analyze_ns;
+  stats.frames++;
+}
+
+void run(jum_AudioSetup* audio, jum_FFTSetup* fft, Signal* signal, double seconds) {
+  ma_int32 frames = seconds * 1000 / FRAME_MS;
+  for (ma_int32 i = 0; i < frames; i++) {
+    step(audio, fft, signal);
+  }
+}
+
+ma_int32 peakBin(const float* bins) {
+  ma_int32 peak = 0;
+  for (ma_int32 i = 1; i < NUM_BINS; i++) {
+    peak = bins[i] > bins[peak] ? i : peak;
+  }
+  return peak;
+}
+
+ma_int32 nearestBin(const jum_FFTSetup* fft, double freq) {
+  ma_int32 nearest = 0;
+  for (ma_int32 i = 1; i < NUM_BINS; i++) {
+    if (fabs(fft->luts.freqs[i] - freq) < fabs(fft->luts.freqs[nearest] - freq)) {
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+// a tone should peak in the bin whose centre frequency is nearest, or one either side
+void checkTones(jum_AudioSetup* audio, jum_FFTSetup* fft) {
+  const double tones[] = {60, 250, 1000, 4000, 12000};
+  Signal signal = {SIGNAL_TONE, 0, 0, 0, 0, 0};
+  char what[128];
+  ma_int32 peak, expected;
+
+  for (ma_uint32 i = 0; i < sizeof(tones) / sizeof(tones[0]); i++) {
+    signal.freq = tones[i];
+    run(audio, fft, &signal, 0.5);
+    peak = peakBin(fft->raw);
+    expected = nearestBin(fft, tones[i]);
+    snprintf(what, sizeof(what), "tone %.0f Hz peaks in bin %d (%.0f Hz), expected %d", tones[i],
+             peak, fft->luts.freqs[peak], expected);
+    check(abs(peak - expected) <= 1, what);
+  }
+}
+
+// audio time from a tone starting until its bin gets to half scale
+void checkLatency(jum_AudioSetup* audio, jum_FFTSetup* fft) {
+  Signal silence = {SIGNAL_SILENCE, 0, 0, 0, 0, 0};
+  Signal tone = {SIGNAL_TONE, 1000, 0, 0, 0, 0};
+  char what[128];
+  ma_int32 bin, frames = 0;
+  double latency_ms;
+
+  run(audio, fft, &silence, 1);
+  bin = nearestBin(fft, tone.freq);
+  while (frames < 1000 / FRAME_MS) {
+    step(audio, fft, &tone);
+    frames++;
+    if (fft->result[bin] >= 0.5F) {
+      break;
+    }
+  }
+  latency_ms = frames * FRAME_MS;
+  snprintf(what, sizeof(what), "onset latency %.0f ms (max %.0f)", latency_ms, MAX_LATENCY_MS);
+  check(latency_ms <= MAX_LATENCY_MS, what);
+}
+
+// the peak should climb steadily through the bins as the sweep rises
+void checkSweep(jum_AudioSetup* audio, jum_FFTSetup* fft) {
+  Signal signal = {SIGNAL_SWEEP, 20, 20000, 10, 0, 0};
+  ma_int32 frames = signal.seconds * 1000 / FRAME_MS;
+  ma_int32 peak, last = 0, backwards = 0;
+  char what[128];
+
+  for (ma_int32 i = 0; i < frames; i++) {
+    step(audio, fft, &signal);
+    peak = peakBin(fft->raw);
+    // skip the first window, it still holds audio from before the sweep
+    if (i * FRAME_MS > FFT_BUF_SIZE * 1000 / SAMPLE_RATE && peak < last - 2) {
+      backwards++;
+    }
+    last = peak;
+  }
+  snprintf(what, sizeof(what), "sweep peak moved backwards %d times, ended in bin %d", backwards,
+           last);
+  check(backwards == 0 && last >= NUM_BINS * 3 / 4, what);
+}
+
+// noise lights up every bin without going out of range, silence after it settles the gate
+void checkNoiseAndSilence(jum_AudioSetup* audio, jum_FFTSetup* fft) {
+  Signal noise = {SIGNAL_NOISE, 0, 0, 0, 12345, 0};
+  Signal silence = {SIGNAL_SILENCE, 0, 0, 0, 0, 0};
+  ma_int32 lit = 0;
+  bool in_range = true;
+  char what[128];
+
+  run(audio, fft, &noise, 2);
+  for (ma_int32 i = 0; i < NUM_BINS; i++) {
+    in_range = in_range && isfinite(fft->result[i]) && fft->result[i] >= 0 && fft->result[i] <= 1;
+    lit += fft->result[i] > 0.01F;
+  }
+  snprintf(what, sizeof(what), "noise output in range, %d of %d bins lit", lit, NUM_BINS);
+  check(in_range && lit >= NUM_BINS * 9 / 10, what);
+
+  run(audio, fft, &silence, 3);
+  check(fft->gate.gated && fft->gate.settled, "silence settles the gate");
+}
+
+// run a reference signal into a fresh setup, after a second of noise so the running max is settled
+void runReference(jum_AudioSetup* audio, const Reference* reference, float* result) {
+  jum_FFTSetup* fft;
+  Signal signal = {SIGNAL_NOISE, 0, 0, 0, 4242, 0};
+
+  jum_openPushInput(audio, SAMPLE_RATE);
+  fft = jum_initFFT(freqs, NUM_FREQS, weights, NUM_WEIGHTS, FFT_BUF_SIZE, NUM_BINS);
+  run(audio, fft, &signal, 1);
+  signal = reference->signal;
+  run(audio, fft, &signal, reference->seconds);
+  memcpy(result, fft->result, NUM_BINS * sizeof(float));
+  jum_deinitFFT(fft);
+}
+
+// each reference signal should still give the output checked in, within what different fft
+// backends and compilers can change
+void checkReferences(jum_AudioSetup* audio) {
+  float result[NUM_BINS];
+  float diff, d;
+  ma_int32 worst;
+  char what[128];
+
+  for (ma_int32 r = 0; r < NUM_REFERENCES; r++) {
+    runReference(audio, &references[r], result);
+    diff = 0;
+    worst = 0;
+    for (ma_int32 i = 0; i < NUM_BINS; i++) {
+      d = fabsf(result[i] - reference_results[r][i]);
+      if (d > diff || isnan(d)) {
+        diff = d;
+        worst = i;
+      }
+    }
+    snprintf(what, sizeof(what), "%s within %.5f of reference (max %.3f, worst bin %d)",
+             references[r].name, diff, MAX_REFERENCE_DIFF, worst);
+    check(diff <= MAX_REFERENCE_DIFF, what);
+  }
+}
+
+// print regression_reference.h from this build's output
+void writeReferences(jum_AudioSetup* audio) {
+  float result[NUM_BINS];
+
+  printf("/* Copyright (c) 2022  Hunter Whyte */\n\n");
+  printf("#ifndef REGRESSION_REFERENCE_H_\n#define REGRESSION_REFERENCE_H_\n\n");
+  printf("// generated by ./regression --write-reference, output of each signal in references\n\n");
+  printf("#define NUM_REFERENCES %d\n\n", NUM_REFERENCES);
+  printf("const float reference_results[NUM_REFERENCES][NUM_BINS] = {\n");
+  for (ma_int32 r = 0; r < NUM_REFERENCES; r++) {
+    runReference(audio, &references[r], result);
+    printf("    {  // %s\n", references[r].name);
+    for (ma_int32 i = 0; i < NUM_BINS; i++) {
+      printf("%s%.6fF,%s", i % 8 == 0 ? "        " : "", result[i], i % 8 == 7 ? "\n" : " ");
+    }
+    printf("    },\n");
+  }
+  printf("};\n\n#endif  // REGRESSION_REFERENCE_H_\n");
+}
+
+// pushing several buffers' worth in one call should leave the buffer as if it was pushed a frame
+// at a time
+void checkLargePush(jum_AudioSetup* audio) {
+  ma_uint32 count = audio->buffer.sz / 2 * 3 + 123;
+  float* frames = (float*)malloc(count * 2 * sizeof(float));
+  float* chunked = (float*)malloc(audio->buffer.sz * sizeof(float));
+  ma_int32 chunked_pos = 0;
+  ma_uint32 chunk;
+  Signal signal = {SIGNAL_NOISE, 0, 0, 0, 99, 0};
+
+  for (ma_uint32 i = 0; i < count; i++) {
+    frames[i * 2] = nextSample(&signal);
+    frames[i * 2 + 1] = -frames[i * 2];
+  }
+  for (ma_int32 pass = 0; pass < 2; pass++) {
+    jum_openPushInput(audio, SAMPLE_RATE);
+    if (pass == 0) {
+      for (ma_uint32 i = 0; i < count; i += FRAME_SAMPLES) {
+        chunk = count - i < FRAME_SAMPLES ? count - i : FRAME_SAMPLES;
+        jum_pushSamples(audio, &frames[i * 2], chunk, ma_format_f32, 2, -1);
+      }
+      memcpy(chunked, audio->buffer.buf, audio->buffer.sz * sizeof(float));
+      chunked_pos = audio->control.writer_pos;
+    } else {
+      jum_pushSamples(audio, frames, count, ma_format_f32, 2, -1);
+    }
+  }
+  check(audio->control.writer_pos >= 0 && audio->control.writer_pos < audio->buffer.sz &&
+            audio->control.writer_pos == chunked_pos &&
+            memcmp(chunked, audio->buffer.buf, audio->buffer.sz * sizeof(float)) == 0,
+        "push larger than the buffer matches pushing it in frames");
+  free(frames);
+  free(chunked);
+}
+
+// the same input through an s16 buffer should stay close to the f32 result
+void checkS16(jum_AudioSetup* audio) {
+  float f32_result[NUM_BINS];
+  float diff = 0;
+  jum_FFTSetup* fft;
+  Signal signal;
+  char what[128];
+
+  for (ma_int32 pass = 0; pass < 2; pass++) {
+    jum_setBufferFormat(audio, pass == 0 ? ma_format_f32 : ma_format_s16);
+    jum_openPushInput(audio, SAMPLE_RATE);
+    fft = jum_initFFT(freqs, NUM_FREQS, weights, NUM_WEIGHTS, FFT_BUF_SIZE, NUM_BINS);
+    signal = (Signal){SIGNAL_NOISE, 0, 0, 0, 4242, 0};
+    run(audio, fft, &signal, 1);
+    signal = (Signal){SIGNAL_SWEEP, 100, 10000, 1, 0, 0};
+    run(audio, fft, &signal, 1);
+    if (pass == 0) {
+      memcpy(f32_result, fft->result, sizeof(f32_result));
+    } else {
+      for (ma_int32 i = 0; i < NUM_BINS; i++) {
+        diff = fmaxf(diff, fabsf(fft->result[i] - f32_result[i]));
+      }
+    }
+    jum_deinitFFT(fft);
+  }
+  jum_setBufferFormat(audio, ma_format_f32);
+  snprintf(what, sizeof(what), "s16 buffer within %.5f of f32 (max %.3f)", diff, MAX_S16_DIFF);
+  check(diff <= MAX_S16_DIFF, what);
+}
+
+int main(int argc, char** argv) {
+  jum_AudioSetup* audio;
+  jum_FFTSetup* fft;
+  double push_us, analyze_us, factor;
+  double max_push_us = 0, max_analyze_us = 0, min_realtime = 0;  // 0 is unchecked
+  bool write_reference = false;
+  char what[128];
+
+  for (ma_int32 i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--max-push-us") == 0 && i + 1 < argc) {
+      max_push_us = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--max-analyze-us") == 0 && i + 1 < argc) {
+      max_analyze_us = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--min-realtime") == 0 && i + 1 < argc) {
+      min_realtime = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--write-reference") == 0) {
+      write_reference = true;
+    } else {
+      printf("usage: %s [--max-push-us us] [--max-analyze-us us] [--min-realtime factor]\n"
+             "       %s --write-reference > regression_reference.h\n",
+             argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  audio = jum_initAudio(FFT_BUF_SIZE * 8, 1, FRAME_SAMPLES);
+  if (audio == NULL) {
+    printf("failed to initialize audio\n");
+    return 1;
+  }
+  if (write_reference) {
+    writeReferences(audio);
+    jum_deinitAudio(audio);
+    return 0;
+  }
+  jum_openPushInput(audio, SAMPLE_RATE);
+  fft = jum_initFFT(freqs, NUM_FREQS, weights, NUM_WEIGHTS, FFT_BUF_SIZE, NUM_BINS);
+  if (fft == NULL) {
+    printf("failed to initialize fft\n");
+    return 1;
+  }
+  printf("fft backend: %s\n", jum_getFFTBackendName(fft));
+
+  checkTones(audio, fft);
+  checkLatency(audio, fft);
+  checkSweep(audio, fft);
+  checkNoiseAndSilence(audio, fft);
+  jum_deinitFFT(fft);
+  checkReferences(audio);
+  checkS16(audio);
+  checkLargePush(audio);
+
+  push_us = stats.push_ns / stats.frames / 1000;
+  analyze_us = stats.analyze_ns / stats.frames / 1000;
+  factor = stats.frames * FRAME_MS * 1e6 / (stats.push_ns + stats.analyze_ns);
+  printf("\n%llu frames, push avg %.1f us max %.1f us, analyze avg %.1f us max %.1f us\n",
+         (unsigned long long)stats.frames, push_us, stats.max_push_ns / 1000, analyze_us,
+         stats.max_analyze_ns / 1000);
+  printf("%.0fx realtime\n", factor);
+  if (max_push_us > 0) {
+    snprintf(what, sizeof(what), "push avg %.1f us (max %.1f)", push_us, max_push_us);
+    check(push_us <= max_push_us, what);
+  }
+  if (max_analyze_us > 0) {
+    snprintf(what, sizeof(what), "analyze avg %.1f us (max %.1f)", analyze_us, max_analyze_us);
+    check(analyze_us <= max_analyze_us, what);
+  }
+  if (min_realtime > 0) {
+    snprintf(what, sizeof(what), "%.0fx realtime (min %.0fx)", factor, min_realtime);
+    check(factor >= min_realtime, what);
+  }
+
+  jum_deinitAudio(audio);
+  printf("%d failed\n", failures);
+  return failures > 0;
+}
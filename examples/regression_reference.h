@@ -0,0 +1,115 @@
+/* Copyright (c) 2022  Hunter Whyte */
+
+#ifndef REGRESSION_REFERENCE_H_
+#define REGRESSION_REFERENCE_H_
+
+// generated by ./regression --write-reference, output of each signal in references
+
+#define NUM_REFERENCES 3
+
+const float reference_results[NUM_REFERENCES][NUM_BINS] = {
+    {  // tone
+        0.002642F, 0.002983F, 0.003340F, 0.003693F, 0.004073F, 0.004484F, 0.004893F, 0.005297F,
+        0.005738F, 0.005867F, 0.005997F, 0.006185F, 0.006409F, 0.006603F, 0.006835F, 0.007138F,
+        0.007428F, 0.007763F, 0.008204F, 0.008635F, 0.009105F, 0.009738F, 0.010521F, 0.011225F,
+        0.012187F, 0.013422F, 0.014552F, 0.016083F, 0.018116F, 0.020135F, 0.022609F, 0.026203F,
+        0.029792F, 0.034322F, 0.041043F, 0.050453F, 0.059285F, 0.065918F, 0.081036F, 0.101222F,
+        0.123086F, 0.155325F, 0.206557F, 0.255277F, 0.325621F, 0.398279F, 0.450004F, 0.510855F,
+        0.557499F, 0.572137F, 0.597084F, 0.595980F, 0.568906F, 0.557095F, 0.511438F, 0.455142F,
+        0.400805F, 0.329746F, 0.258194F, 0.204958F, 0.148032F, 0.112048F, 0.087143F, 0.069520F,
+        0.056963F, 0.048586F, 0.039499F, 0.032871F, 0.027966F, 0.024281F, 0.021487F, 0.019478F,
+        0.017263F, 0.015500F, 0.013776F, 0.012721F, 0.011830F, 0.010940F, 0.010169F, 0.009506F,
+        0.008918F, 0.008440F, 0.008064F, 0.007711F, 0.007380F, 0.007142F, 0.006959F, 0.006824F,
+        0.006687F, 0.006590F, 0.006552F, 0.006516F, 0.006474F, 0.006426F, 0.006396F, 0.006351F,
+        0.006310F, 0.006257F, 0.006219F, 0.006172F, 0.006107F, 0.006057F, 0.006010F, 0.005971F,
+        0.005938F, 0.005941F, 0.005942F, 0.005969F, 0.005969F, 0.005971F, 0.005998F, 0.006002F,
+        0.006033F, 0.006008F, 0.006042F, 0.006069F, 0.006067F, 0.006048F, 0.006096F, 0.006125F,
+        0.006093F, 0.006091F, 0.006094F, 0.006099F, 0.006065F, 0.006066F, 0.006089F, 0.006116F,
+        0.006124F, 0.006138F, 0.006184F, 0.006198F, 0.006197F, 0.006197F, 0.006217F, 0.006239F,
+        0.006251F, 0.006296F, 0.006325F, 0.006390F, 0.006416F, 0.006499F, 0.006569F, 0.006654F,
+        0.006688F, 0.006795F, 0.006875F, 0.006937F, 0.007023F, 0.007133F, 0.007164F, 0.007233F,
+        0.007318F, 0.007326F, 0.007358F, 0.007386F, 0.007417F, 0.007434F, 0.007489F, 0.007542F,
+        0.007581F, 0.007684F, 0.007708F, 0.007713F, 0.007788F, 0.007798F, 0.007833F, 0.007900F,
+        0.007918F, 0.007946F, 0.007976F, 0.007990F, 0.007969F, 0.007972F, 0.008014F, 0.008055F,
+        0.008077F, 0.008123F, 0.008176F, 0.008172F, 0.008225F, 0.008245F, 0.008217F, 0.008279F,
+        0.008229F, 0.008219F, 0.008150F, 0.008152F, 0.008161F, 0.008219F, 0.008224F, 0.008263F,
+        0.008227F, 0.008253F, 0.008219F, 0.008230F, 0.008211F, 0.008223F, 0.008219F, 0.008215F,
+        0.008180F, 0.008144F, 0.008122F, 0.008106F, 0.008137F, 0.008130F, 0.008169F, 0.008161F,
+        0.008219F, 0.008189F, 0.008210F, 0.008186F, 0.008212F, 0.008235F, 0.008245F, 0.008247F,
+        0.008205F, 0.008197F, 0.008167F, 0.008191F, 0.008152F, 0.008190F, 0.008245F, 0.008226F,
+        0.008124F, 0.008056F, 0.008131F, 0.008225F, 0.008239F, 0.008241F, 0.008195F, 0.008152F,
+        0.008174F, 0.008175F, 0.008163F, 0.008170F, 0.008165F, 0.008167F, 0.008161F, 0.008152F,
+        0.008195F, 0.008215F, 0.008211F, 0.008200F, 0.008171F, 0.008137F, 0.008105F, 0.008144F,
+        0.008200F, 0.008208F, 0.008177F, 0.008105F, 0.008088F, 0.008114F, 0.008137F, 0.006127F,
+    },
+    {  // sweep
+        0.000908F, 0.001022F, 0.001135F, 0.001249F, 0.001363F, 0.001477F, 0.001591F, 0.001705F,
+        0.001819F, 0.001820F, 0.001821F, 0.001822F, 0.001823F, 0.001824F, 0.001826F, 0.001827F,
+        0.001829F, 0.001831F, 0.001833F, 0.001834F, 0.001836F, 0.001839F, 0.001841F, 0.001844F,
+        0.001846F, 0.001850F, 0.001852F, 0.001855F, 0.001859F, 0.001863F, 0.001867F, 0.001871F,
+        0.001876F, 0.001881F, 0.001887F, 0.001893F, 0.001899F, 0.001905F, 0.001912F, 0.001920F,
+        0.001929F, 0.001940F, 0.001953F, 0.001966F, 0.001982F, 0.001999F, 0.002020F, 0.002042F,
+        0.002067F, 0.002093F, 0.002122F, 0.002154F, 0.002187F, 0.002220F, 0.002254F, 0.002288F,
+        0.002324F, 0.002360F, 0.002396F, 0.002430F, 0.002467F, 0.002503F, 0.002540F, 0.002577F,
+        0.002615F, 0.002650F, 0.002688F, 0.002726F, 0.002765F, 0.002805F, 0.002845F, 0.002884F,
+        0.002928F, 0.002975F, 0.003017F, 0.003071F, 0.003127F, 0.003191F, 0.003263F, 0.003339F,
+        0.003422F, 0.003510F, 0.003604F, 0.003704F, 0.003806F, 0.003914F, 0.004023F, 0.004138F,
+        0.004254F, 0.004373F, 0.004500F, 0.004626F, 0.004759F, 0.004893F, 0.005032F, 0.005176F,
+        0.005322F, 0.005474F, 0.005629F, 0.005790F, 0.005956F, 0.006124F, 0.006301F, 0.006476F,
+        0.006663F, 0.006848F, 0.007039F, 0.007238F, 0.007433F, 0.007644F, 0.007842F, 0.008057F,
+        0.008275F, 0.008505F, 0.008735F, 0.008973F, 0.009222F, 0.009467F, 0.009721F, 0.009991F,
+        0.010253F, 0.010521F, 0.010810F, 0.011089F, 0.011369F, 0.011693F, 0.012044F, 0.012411F,
+        0.012838F, 0.013313F, 0.013834F, 0.014391F, 0.015013F, 0.015667F, 0.016387F, 0.017138F,
+        0.017951F, 0.018811F, 0.019738F, 0.020724F, 0.021755F, 0.022871F, 0.024022F, 0.025249F,
+        0.026498F, 0.027814F, 0.029182F, 0.030536F, 0.032041F, 0.033479F, 0.035065F, 0.036565F,
+        0.038174F, 0.039950F, 0.041851F, 0.044064F, 0.046491F, 0.049251F, 0.052193F, 0.055364F,
+        0.058671F, 0.062075F, 0.065630F, 0.069275F, 0.073075F, 0.076958F, 0.081031F, 0.085169F,
+        0.089531F, 0.093942F, 0.098590F, 0.103373F, 0.108252F, 0.113529F, 0.118679F, 0.124297F,
+        0.129753F, 0.135642F, 0.142127F, 0.148874F, 0.156933F, 0.165340F, 0.174914F, 0.184745F,
+        0.195270F, 0.206718F, 0.217398F, 0.230045F, 0.241178F, 0.255047F, 0.266820F, 0.281829F,
+        0.294416F, 0.310488F, 0.324164F, 0.341064F, 0.356092F, 0.373268F, 0.389929F, 0.406667F,
+        0.425135F, 0.441994F, 0.462142F, 0.480625F, 0.502279F, 0.525370F, 0.551572F, 0.581392F,
+        0.613592F, 0.647172F, 0.683237F, 0.717810F, 0.756539F, 0.792050F, 0.830887F, 0.865461F,
+        0.897656F, 0.922336F, 0.936058F, 0.941127F, 0.938167F, 0.921209F, 0.884919F, 0.820943F,
+        0.731479F, 0.612188F, 0.469932F, 0.313475F, 0.154849F, 0.046309F, 0.009632F, 0.004792F,
+        0.004074F, 0.003943F, 0.003919F, 0.003912F, 0.003909F, 0.003908F, 0.003907F, 0.003907F,
+        0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F,
+        0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.003907F, 0.002930F,
+    },
+    {  // noise
+        0.229063F, 0.259686F, 0.286413F, 0.310711F, 0.338081F, 0.365728F, 0.394180F, 0.424808F,
+        0.448078F, 0.449568F, 0.448108F, 0.451830F, 0.454462F, 0.456816F, 0.458233F, 0.455509F,
+        0.463165F, 0.469240F, 0.477506F, 0.479813F, 0.477950F, 0.472992F, 0.469160F, 0.468969F,
+        0.468072F, 0.465692F, 0.461119F, 0.453835F, 0.447929F, 0.443579F, 0.441698F, 0.444445F,
+        0.445142F, 0.442144F, 0.437934F, 0.436209F, 0.435196F, 0.437455F, 0.441795F, 0.444183F,
+        0.442970F, 0.447652F, 0.451020F, 0.454919F, 0.457227F, 0.461817F, 0.461879F, 0.466342F,
+        0.465487F, 0.467422F, 0.467541F, 0.476296F, 0.481212F, 0.488398F, 0.490513F, 0.494058F,
+        0.493958F, 0.496485F, 0.501423F, 0.504153F, 0.507172F, 0.512687F, 0.520873F, 0.528200F,
+        0.540739F, 0.543136F, 0.547806F, 0.551238F, 0.556839F, 0.564108F, 0.574095F, 0.580063F,
+        0.585713F, 0.584260F, 0.583411F, 0.583085F, 0.580449F, 0.587429F, 0.584307F, 0.576775F,
+        0.573446F, 0.573922F, 0.589131F, 0.584971F, 0.580931F, 0.591290F, 0.600457F, 0.608205F,
+        0.600590F, 0.600817F, 0.616217F, 0.631494F, 0.637067F, 0.640465F, 0.647499F, 0.661065F,
+        0.676492F, 0.677534F, 0.682489F, 0.696028F, 0.704900F, 0.717172F, 0.706874F, 0.704325F,
+        0.710032F, 0.708297F, 0.712407F, 0.697623F, 0.699172F, 0.700587F, 0.704315F, 0.693679F,
+        0.693670F, 0.698456F, 0.703104F, 0.701335F, 0.712827F, 0.722993F, 0.725473F, 0.729040F,
+        0.737461F, 0.724287F, 0.722890F, 0.724611F, 0.719203F, 0.701866F, 0.696381F, 0.694203F,
+        0.685206F, 0.689947F, 0.693029F, 0.699244F, 0.691145F, 0.700088F, 0.703628F, 0.714243F,
+        0.715220F, 0.723928F, 0.730389F, 0.734157F, 0.742252F, 0.752752F, 0.766820F, 0.767039F,
+        0.776631F, 0.781724F, 0.797870F, 0.806682F, 0.810578F, 0.815451F, 0.829627F, 0.822010F,
+        0.814615F, 0.824658F, 0.816241F, 0.823460F, 0.827632F, 0.837129F, 0.849921F, 0.847644F,
+        0.863049F, 0.876445F, 0.878098F, 0.895046F, 0.919910F, 0.906083F, 0.904973F, 0.916137F,
+        0.896837F, 0.892945F, 0.893975F, 0.899386F, 0.901292F, 0.913113F, 0.942087F, 0.937029F,
+        0.938484F, 0.963369F, 0.941838F, 0.929595F, 0.946740F, 0.925958F, 0.931010F, 0.933982F,
+        0.949578F, 0.953118F, 0.948268F, 0.934964F, 0.930018F, 0.921438F, 0.939819F, 0.933831F,
+        0.954099F, 0.940100F, 0.949353F, 0.945831F, 0.943949F, 0.948047F, 0.940830F, 0.940626F,
+        0.936608F, 0.930086F, 0.928528F, 0.918026F, 0.923632F, 0.918189F, 0.925528F, 0.923608F,
+        0.930005F, 0.922853F, 0.924469F, 0.921660F, 0.925237F, 0.929049F, 0.936235F, 0.933103F,
+        0.925743F, 0.905123F, 0.899833F, 0.894238F, 0.907759F, 0.924357F, 0.917628F, 0.931016F,
+        0.958562F, 0.960825F, 0.946208F, 0.942093F, 0.945641F, 0.948399F, 0.951040F, 0.935273F,
+        0.917459F, 0.918750F, 0.921495F, 0.917199F, 0.913956F, 0.915378F, 0.924155F, 0.944605F,
+        0.959342F, 0.941788F, 0.904355F, 0.898685F, 0.916059F, 0.925703F, 0.929852F, 0.914406F,
+        0.904758F, 0.914409F, 0.911009F, 0.904875F, 0.919973F, 0.932352F, 0.932417F, 0.704971F,
+    },
+};
+
+#endif  // REGRESSION_REFERENCE_H_
@@ -69,6 +69,7 @@ int main(int argc, char* argv[]) {
 
   if (playback) {
   } else {
+    jum_getDevices(audio, false);
     printf("Capture Devices\n");
     for (i = 0; i < audio->capture_device_count; ++i) {
       printf("  %u: %s\n", i, audio->capture_device_info[i].name);
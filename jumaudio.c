@@ -1,35 +1,161 @@
 /* Copyright (c) 2022  Hunter Whyte */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // O_DIRECT
+#endif
 #include "jumaudio.h"
 
+#include <fcntl.h>
 #include <math.h>
-#include <semaphore.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "pffft/pffft.h"
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio/miniaudio.h"
 
+// time the enclosing scope into this thread's trace ring, nothing unless built with JUMAUDIO_TRACE
+#ifdef JUMAUDIO_TRACE
+#define TRACE_SCOPE(name) \
+  TraceScope trace_scope __attribute__((cleanup(traceEnd))) = traceBegin(name)
+TraceScope traceBegin(const char* name);
+void traceEnd(TraceScope* scope);
+ma_uint64 traceNow(void);
+
+TraceRing trace_rings[TRACE_THREADS];
+ma_uint32 trace_num_rings;
+__thread TraceRing* trace_ring;
+__thread bool trace_untraced;  // thread came after all rings were claimed
+#else
+#define TRACE_SCOPE(name)
+#endif
+
 void captureCallback(ma_device* p_device, void* p_output, const void* p_input,
                      ma_uint32 frame_count);
 void playbackCallback(ma_device* p_device, void* p_output, const void* p_input,
                       ma_uint32 frame_count);
+void duplexCallback(ma_device* p_device, void* p_output, const void* p_input,
+                    ma_uint32 frame_count);
+void writeCapturedFrames(jum_AudioSetup* setup, const float* frames, ma_uint32 frame_count);
+void publishWriterPos(jum_AudioSetup* setup, ma_int32 reader_pos, ma_int32 writer_pos);
+void pushStereoFrames(jum_AudioSetup* setup, const void* frames, ma_uint32 count,
+                      ma_format format, ma_uint32 channels);
+void deviceNotification(const ma_device_notification* notification);
+void fftTapProcess(ma_node* p_node, const float** pp_frames_in, ma_uint32* p_frame_count_in,
+                   float** pp_frames_out, ma_uint32* p_frame_count_out);
+ma_int32 writeIntoAudioBuffer(AudioBuffer* buffer, ma_int32 writer_pos, const float* frames,
+                              ma_uint32 frame_count, ma_uint32 channels);
+void readFromAudioBuffer(const AudioBuffer* buffer, ma_int32 reader_pos, float* samples,
+                         ma_uint32 count);
+void clearAudioBuffer(AudioBuffer* buffer);
+void convertToS16(ma_int16* out, const float* in, ma_uint32 count);
+void convertFromS16(float* out, const ma_int16* in, ma_uint32 count);
 void closePlaybackDevice(jum_AudioSetup* setup);
+ma_int32 openOutputDevice(jum_AudioSetup* setup, ma_device_type type, ma_int32 playback_index,
+                          ma_int32 capture_index);
 void closeCaptureDevice(jum_AudioSetup* setup);
+ma_result initResourceManager(jum_AudioSetup* setup, ma_uint32 job_threads);
+ma_result initSoundFile(jum_AudioSetup* setup, SoundFile* sound_file, const char* filepath);
+ma_result queueSoundFile(jum_AudioSetup* setup, ma_int32 handle);
+void soundLoaded(ma_async_notification* notification);
+ma_int32 soundStatus(SoundFile* sound_file);
+ma_int32 findSoundFile(jum_AudioSetup* setup, const char* filepath);
+void openSongSeeker(jum_AudioSetup* setup);
+void* buildSongSeeker(void* arg);
+void closeSongSeeker(jum_AudioSetup* setup);
+void cancelPrime(SeekPrime* prime);
+ma_sound* songSound(jum_AudioSetup* setup);
+void openWaveform(jum_AudioSetup* setup);
+void closeWaveform(Waveform* waveform);
+void updateWaveform(Waveform* waveform);
+void pushWaveformEntry(Waveform* waveform, ma_int32 level, const jum_WaveformPeak* entry);
+void recordFrames(Recorder* recorder, const float* frames, ma_uint32 frame_count);
+void* recordWriter(void* arg);
+void writeRecordBatch(Recorder* recorder, ma_uint32 count);
+void closeRecording(Recorder* recorder);
 void readIntoFFTBuffer(const float* samples_in, ma_int32 in_pos, ma_int32 in_size,
                        float* samples_out, ma_int32 out_size, const float* hamming,
                        ma_int32 channels);
-void readIntoBins(float* out, const float* freqs, ma_int32 out_sz, const float* fft,
+void readIntoFFTBufferS16(const ma_int16* samples_in, ma_int32 in_pos, ma_int32 in_size,
+                          float* samples_out, ma_int32 out_size, const float* hamming,
+                          ma_int32 channels);
+void readMagnitudes(float* magnitudes, const float* fft, ma_int32 fft_sz);
+void readIntoBins(float* out, const float* freqs, ma_int32 out_sz, const float* magnitudes,
                   ma_int32 fft_sz, float sample_rate);
+void updateLayout(jum_FFTLayout* layout, const jum_FFTSetup* fft, float sample_rate,
+                  ma_int32 spread);
+float decayLayout(jum_FFTLayout* layout);
+void adoptPendingPlan(jum_FFTSetup* fft);
+void resampleBins(float* array, const float* from_freqs, ma_int32 from_sz, const float* to_freqs,
+                  ma_int32 to_sz, float* scratch);
 float averageLevel(const float* samples, ma_int32 sz, float prev_level);
+void resetMeter(Meter* meter, ma_uint32 sample_rate);
+void initMeter(Meter* meter, ma_uint32 sample_rate);
+void updateMeter(Meter* meter, const float* frames, ma_uint32 frame_count, ma_uint32 channels);
+void publishMeter(Meter* meter);
+float meterLoudness(const Meter* meter, ma_uint32 num_blocks);
+float processBiquad(const Biquad* filter, float* state, float x);
 void applyWeighting(float* data, const float* weights, ma_int32 size);
 void applyAveraging(const float* current, float* averaged, ma_int32 size);
-void applySmoothing(const float* in, float* out, ma_int32 size);
-float normalizeArray(float* array, ma_int32 size, float max);
-void initPFFFT(PFFFTInfo* info, ma_int32 size);
+bool windowIsSilent(SilenceGate* gate, const AudioBuffer* buffer, ma_int32 window_pos,
+                    ma_int32 window_sz);
+float decayToFloor(float* averaged, const float* weights, ma_int32 size);
+void applySmoothing(const float* in, float* out, ma_int32 size, ma_int32 spread);
+float elapsedMs(struct timespec* since);
+void adaptQuality(jum_FFTSetup* fft, const float* stage_ms);
+void applyQualityLevel(jum_FFTSetup* fft, jum_Quality level);
+float normalizeArray(float* array, ma_int32 size, float max, const OutputTarget* target);
+ma_uint16 floatToHalf(float x);
+void storeOutput(void* dst, jum_OutputType type, float x);
+size_t outputTypeSize(jum_OutputType type);
+void recordHistory(History* history, const float* result, ma_int32 num_bins);
+void initOnsetTracker(OnsetTracker* tracker);
+void detectOnsets(jum_FFTSetup* fft, ma_uint32 msec);
+void trackTempo(jum_FFTSetup* fft, float strength, ma_uint32 msec);
 void deinitPFFFT(PFFFTInfo* info);
+const FFTBackend* createFFTSetup(ma_int32 size, void** setup);
+bool pffftSupported(void);
+void* pffftCreate(ma_int32 size);
+void pffftDestroy(void* setup);
+void pffftTransform(void* setup, const float* in, float* out, float* work);
+#if defined(__x86_64__) || defined(__i386__)
+typedef struct simd_fft SimdFFT;
+void* simdFFTCreate(ma_int32 size, ma_int32 width);
+void simdFFTDestroy(void* setup);
+void simdFFTPostScalar(const SimdFFT* f, const float* zr, const float* zi, float* out,
+                       ma_int32 k);
+bool avx2Supported(void);
+void* avx2Create(ma_int32 size);
+void avx2Stage(const SimdFFT* f, ma_int32 stage, ma_int32 s, const float* xr, const float* xi,
+               float* yr, float* yi);
+void avx2Transform(void* setup, const float* in, float* out, float* work);
+bool avx512Supported(void);
+void* avx512Create(ma_int32 size);
+void avx512Stage(const SimdFFT* f, ma_int32 stage, ma_int32 s, const float* xr, const float* xi,
+                 float* yr, float* yi);
+void avx512Transform(void* setup, const float* in, float* out, float* work);
+#endif
+size_t alignSize(size_t size);
+float* arenaArray(char* base, size_t* offset, size_t count);
+size_t layoutFFTSetup(jum_FFTSetup* setup, char* base, ma_int32 fft_sz, ma_int32 num_bins);
+FFTPlan* acquireFFTPlan(const float freq_points[][2], ma_int32 freqs_sz,
+                        const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
+                        ma_int32 num_bins);
+void releaseFFTPlan(FFTPlan* plan);
 void buildWeightTable(const float* freq_bins, ma_int32 num_bins, const float in_weights[][2],
                       ma_int32 num_weights, float* out_weights);
 void buildFreqTable(float* freq_bins, ma_int32 num_bins, const float in_freqs[][2],
@@ -39,186 +165,413 @@ float lerpArray(const float array[][2], ma_int32 size, float x);
 
 const char* stream_name = "jum";
 
+// floats converted on the stack at a time by jum_pushSamples
+#define PUSH_CHUNK_SAMPLES 1024
+
+// default spread for applySmoothing
+#define SMOOTHING_SPREAD 7
+
+// what applyWeighting produces for a bin with no energy, before the weight is applied
+#define SILENT_LEVEL (log10f(0.5F) + 0.31F)
+
+// plans shared between fft setups, only touched on init/deinit
+FFTPlan* plan_cache = NULL;
+pthread_mutex_t plan_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// single input/output bus, keep processing with no song playing so the buffer positions advance
+ma_node_vtable fft_tap_vtable = {fftTapProcess, NULL, 1, 1, MA_NODE_FLAG_CONTINUOUS_PROCESSING};
+
+// copy interleaved frames into circular audio buffer, returns the new writer position
+ma_int32 writeIntoAudioBuffer(AudioBuffer* buffer, ma_int32 writer_pos, const float* frames,
+                              ma_uint32 frame_count, ma_uint32 channels) {
+  ma_uint32 remaining;
+  ma_uint32 first, second;
+
+  remaining = (buffer->sz - writer_pos) / channels;
+  first = (remaining > frame_count ? frame_count : remaining) * channels;
+  second = frame_count * channels - first;
+  if (buffer->format == ma_format_s16) {
+    convertToS16(&buffer->buf_s16[writer_pos], frames, first);
+    convertToS16(&buffer->buf_s16[0], &frames[first], second);
+  } else {
+    memcpy(&buffer->buf[writer_pos], frames, first * sizeof(float));
+    memcpy(&buffer->buf[0], &frames[first], second * sizeof(float));
+  }
+
+  writer_pos += frame_count * channels;
+  if (writer_pos >= buffer->sz) {
+    writer_pos -= buffer->sz;
+  }
+  return writer_pos;
+}
+
+// copy count samples starting at reader_pos out of the circular audio buffer as f32
+void readFromAudioBuffer(const AudioBuffer* buffer, ma_int32 reader_pos, float* samples,
+                         ma_uint32 count) {
+  ma_uint32 first, second;
+
+  first = (ma_uint32)(buffer->sz - reader_pos);
+  first = first > count ? count : first;
+  second = count - first;
+  if (buffer->format == ma_format_s16) {
+    convertFromS16(samples, &buffer->buf_s16[reader_pos], first);
+    convertFromS16(&samples[first], &buffer->buf_s16[0], second);
+  } else {
+    memcpy(samples, &buffer->buf[reader_pos], first * sizeof(float));
+    memcpy(&samples[first], &buffer->buf[0], second * sizeof(float));
+  }
+}
+
+void clearAudioBuffer(AudioBuffer* buffer) {
+  if (buffer->format == ma_format_s16) {
+    memset(buffer->buf_s16, 0, buffer->allocated_sz * sizeof(ma_int16));
+  } else {
+    memset(buffer->buf, 0, buffer->allocated_sz * sizeof(float));
+  }
+}
+
+// f32 -> s16 with saturation, runs in the audio callback for every sample written
+void convertToS16(ma_int16* out, const float* in, ma_uint32 count) {
+  ma_uint32 i = 0;
+  float x;
+#if defined(__SSE2__)
+  __m128 scale = _mm_set1_ps(32767.0F);
+  __m128 max = _mm_set1_ps(32767.0F);
+  __m128 min = _mm_set1_ps(-32768.0F);
+  __m128i lo, hi;
+  // clamp before converting, out of range floats would otherwise convert to 0x80000000
+  for (; i + 8 <= count; i += 8) {
+    lo = _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(&in[i]), scale), max), min));
+    hi = _mm_cvtps_epi32(
+        _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(&in[i + 4]), scale), max), min));
+    _mm_storeu_si128((__m128i*)&out[i], _mm_packs_epi32(lo, hi));
+  }
+#elif defined(__ARM_NEON)
+  float32x4_t scale = vdupq_n_f32(32767.0F);
+  float32x4_t max = vdupq_n_f32(32767.0F);
+  float32x4_t min = vdupq_n_f32(-32768.0F);
+  int32x4_t lo, hi;
+  for (; i + 8 <= count; i += 8) {
+    lo = vcvtnq_s32_f32(vmaxq_f32(vminq_f32(vmulq_f32(vld1q_f32(&in[i]), scale), max), min));
+    hi = vcvtnq_s32_f32(vmaxq_f32(vminq_f32(vmulq_f32(vld1q_f32(&in[i + 4]), scale), max), min));
+    vst1q_s16(&out[i], vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+  }
+#endif
+  for (; i < count; i++) {
+    x = in[i] * 32767.0F;
+    if (x > 32767.0F)
+      x = 32767.0F;
+    if (x < -32768.0F)
+      x = -32768.0F;
+    out[i] = (ma_int16)lrintf(x);
+  }
+}
+
+void convertFromS16(float* out, const ma_int16* in, ma_uint32 count) {
+  ma_uint32 i = 0;
+#if defined(__SSE2__)
+  __m128 scale = _mm_set1_ps(1.0F / 32767.0F);
+  __m128i v;
+  for (; i + 8 <= count; i += 8) {
+    v = _mm_loadu_si128((const __m128i*)&in[i]);
+    // sign extend by unpacking into the high half then shifting down
+    _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)),
+                                      scale));
+    _mm_storeu_ps(&out[i + 4],
+                  _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), scale));
+  }
+#elif defined(__ARM_NEON)
+  float32x4_t scale = vdupq_n_f32(1.0F / 32767.0F);
+  int16x8_t v;
+  for (; i + 8 <= count; i += 8) {
+    v = vld1q_s16(&in[i]);
+    vst1q_f32(&out[i], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+    vst1q_f32(&out[i + 4], vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+  }
+#endif
+  for (; i < count; i++) {
+    out[i] = in[i] * (1.0F / 32767.0F);
+  }
+}
+
 void captureCallback(ma_device* p_device, void* p_output, const void* p_input,
                      ma_uint32 frame_count) {
+  TRACE_SCOPE(__func__);
   jum_AudioSetup* setup;
-  ma_int32 reader_pos;
-  ma_int32 writer_pos;
-  ma_uint32 remaining;
-  float* input;
   (void)p_output;
 
   setup = (jum_AudioSetup*)p_device->pUserData;
-  writer_pos = setup->control.writer_pos;
-  remaining = (setup->buffer.sz - writer_pos) / setup->info.channels;
 
   if (setup->mode != AUDIO_MODE_CAPTURE || !p_input) {
     return;
   }
+  writeCapturedFrames(setup, (const float*)p_input, frame_count);
+}
 
-  input = (float*)p_input;
-  if (remaining > frame_count) {
-    memcpy(&setup->buffer.buf[writer_pos], input,
-           frame_count * setup->info.channels * sizeof(float));
-  } else {
-    memcpy(&setup->buffer.buf[writer_pos], input, remaining * setup->info.channels * sizeof(float));
-    memcpy(&setup->buffer.buf[0], &input[remaining * setup->info.channels],
-           (frame_count - remaining) * setup->info.channels * sizeof(float));
-  }
-  reader_pos = writer_pos;
+// captured frames are analyzed as soon as they arrive, there is no output to line up with
+void writeCapturedFrames(jum_AudioSetup* setup, const float* frames, ma_uint32 frame_count) {
+  ma_int32 reader_pos;
+  ma_int32 writer_pos;
 
+  writer_pos = setup->control.writer_pos;
+  reader_pos = writer_pos;
   // printf("writer: %d reader: %d frames %d\n", audio_control.writer_pos, reader_pos, frame_count);
-  // increment writer pointer
-  writer_pos += frame_count * setup->info.channels;
-  if (writer_pos >= setup->buffer.sz) {
-    writer_pos -= setup->buffer.sz;
-  }
+  writer_pos = writeIntoAudioBuffer(&setup->buffer, writer_pos, frames, frame_count,
+                                    setup->info.channels);
+  updateMeter(&setup->meter, frames, frame_count, setup->info.channels);
+  recordFrames(&setup->recorder, frames, frame_count);
+  publishWriterPos(setup, reader_pos, writer_pos);
+}
+
+// never blocks, analyzers pick the new reader position up whenever they next run
+void publishWriterPos(jum_AudioSetup* setup, ma_int32 reader_pos, ma_int32 writer_pos) {
+  ma_uint64 count;
 
-  sem_wait(&setup->control.mutex);
   setup->control.writer_pos = writer_pos;
-  setup->control.reader_pos = reader_pos;
-  setup->control.new_data_flag = true;
-  sem_post(&setup->control.mutex);
+  count = (__atomic_load_n(&setup->control.published, __ATOMIC_RELAXED) >> 32) + 1;
+  __atomic_store_n(&setup->control.published, (count << 32) | (ma_uint32)reader_pos,
+                   __ATOMIC_RELEASE);
 }
 
 void playbackCallback(ma_device* p_device, void* p_output, const void* p_input,
                       ma_uint32 frame_count) {
+  TRACE_SCOPE(__func__);
   jum_AudioSetup* setup;
-  ma_uint64 frames_read;
-  ma_int32 reader_pos;
-  ma_int32 writer_pos;
-  ma_uint32 remaining;
-  float* output;
-  ma_uint32 i;
   (void)p_input;
 
   setup = (jum_AudioSetup*)p_device->pUserData;
-  writer_pos = setup->control.writer_pos;
-  remaining = (setup->buffer.sz - writer_pos) / setup->info.channels;
 
   if (!p_output || !setup->playback_open) {
     return;
   }
 
-  output = (float*)p_output;
+  // music and other groups are mixed by the engine, music is tapped for fft on the way through
+  {
+    TRACE_SCOPE("ma_engine_read_pcm_frames");
+    ma_engine_read_pcm_frames(&setup->engine, p_output, frame_count, NULL);
+  }
+  // other modes record their input, one producer per mode
+  if (setup->mode == AUDIO_MODE_PLAYBACK) {
+    recordFrames(&setup->recorder, (const float*)p_output, frame_count);
+  }
+}
 
-  // read samples from non fft audio source
-  if (frame_count * setup->info.bytes_per_frame > setup->conversion_sz) {
-#ifdef JUMAUDIO_DEBUG
-    printf("error, requesting more frames than we have room for in temp buffer\n");
-#endif
+// input and output share one device clock, so the input goes straight to the analysis buffer and
+// the output without buffering between two devices
+void duplexCallback(ma_device* p_device, void* p_output, const void* p_input,
+                    ma_uint32 frame_count) {
+  TRACE_SCOPE(__func__);
+  jum_AudioSetup* setup;
+  const float* input;
+  float* output;
+  float volume;
+  ma_uint32 i;
+
+  setup = (jum_AudioSetup*)p_device->pUserData;
+
+  if (!p_output || !setup->playback_open) {
     return;
-  } else {
-    ma_engine_read_pcm_frames(&setup->other_engine, setup->conversion_buf, frame_count,
-                              &frames_read);
-    for (i = 0; i < frame_count * setup->info.channels; i++) {
-      output[i] = setup->conversion_buf[i] * setup->control.other_volume;
-    }
   }
 
-  if (setup->mode != AUDIO_MODE_PLAYBACK) {
+  // effects and music mixed by the engine as in playback
+  {
+    TRACE_SCOPE("ma_engine_read_pcm_frames");
+    ma_engine_read_pcm_frames(&setup->engine, p_output, frame_count, NULL);
+  }
+  if (setup->mode == AUDIO_MODE_PLAYBACK) {
+    recordFrames(&setup->recorder, (const float*)p_output, frame_count);
+  }
+  if (setup->mode != AUDIO_MODE_DUPLEX || !p_input) {
     return;
   }
 
-  // convert from decoder output format to 32 bit float and copy to the audio buffer
-  if (remaining > frame_count) {
-    ma_engine_read_pcm_frames(&setup->music_engine, &setup->buffer.buf[writer_pos], frame_count,
-                              &frames_read);
-  } else {
-    ma_engine_read_pcm_frames(&setup->music_engine, &setup->buffer.buf[writer_pos], remaining,
-                              &frames_read);
-    ma_engine_read_pcm_frames(&setup->music_engine, &setup->buffer.buf[0], frame_count - remaining,
-                              &frames_read);
+  input = (const float*)p_input;
+  output = (float*)p_output;
+  writeCapturedFrames(setup, input, frame_count);
+  volume = setup->control.monitor_volume;
+  if (volume > 0) {
+    for (i = 0; i < frame_count * setup->info.channels; i++) {
+      output[i] += input[i] * volume;
+    }
   }
+}
+
+// runs on the audio thread while the engine pulls the music group, only started in playback mode
+void fftTapProcess(ma_node* p_node, const float** pp_frames_in, ma_uint32* p_frame_count_in,
+                   float** pp_frames_out, ma_uint32* p_frame_count_out) {
+  TRACE_SCOPE(__func__);
+  jum_AudioSetup* setup;
+  ma_uint32 frame_count;
+  ma_int32 reader_pos;
+  ma_int32 writer_pos;
+  ma_int32 expected = PRIME_READY;
+  ma_uint32 primed;
+  float* output;
+
+  setup = ((FFTTapNode*)p_node)->setup;
+  frame_count = *p_frame_count_out;
+  writer_pos = setup->control.writer_pos;
+  output = pp_frames_out[0];
 
   // determine where the reader pointer should be based on the writer
   reader_pos = writer_pos - (setup->predecode_bufs * setup->info.period * setup->info.channels);
   if (reader_pos < 0)
     reader_pos = setup->buffer.sz + reader_pos;
 
-  // copy from reader pointer to output stream
-  for (i = 0; i < frame_count * setup->info.channels; i++) {
-    output[i] +=
-        setup->buffer.buf[(reader_pos + i) % setup->buffer.sz] * setup->control.music_volume;
+  if (__atomic_compare_exchange_n(&setup->prime.state, &expected, PRIME_APPLYING, false,
+                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    // seeked, replace everything predecoded with audio from the target. this period's input is
+    // from before the seek so it's dropped, the sound picks up right after the primed frames
+    primed = setup->predecode_bufs * setup->info.period + frame_count;
+    if (primed > setup->prime.frames) {
+      primed = setup->prime.frames;
+    }
+    writer_pos = writeIntoAudioBuffer(&setup->buffer, reader_pos, setup->prime.buf, primed,
+                                      setup->info.channels);
+    ma_sound_seek_to_pcm_frame(setup->prime.sound, (setup->prime.target + primed) *
+                                                       setup->prime.src_rate /
+                                                       setup->info.sample_rate);
+    __atomic_store_n(&setup->prime.state, PRIME_IDLE, __ATOMIC_RELEASE);
+  } else {
+    // copy decoded music into the audio buffer ahead of what is being output
+    writer_pos = writeIntoAudioBuffer(&setup->buffer, writer_pos, pp_frames_in[0], frame_count,
+                                      setup->info.channels);
   }
 
-  // printf("writer: %d reader: %d frames %d\n", audio_control.writer_pos, reader_pos, frame_count);
-  // increment writer pointer
-  writer_pos += frame_count * setup->info.channels;
-  if (writer_pos >= setup->buffer.sz) {
-    writer_pos -= setup->buffer.sz;
-  }
+  // copy from reader pointer to output, volume is applied on the node's output bus
+  readFromAudioBuffer(&setup->buffer, reader_pos, output, frame_count * setup->info.channels);
+  *p_frame_count_in = frame_count;
+  // meter what is being output so it lines up with what is heard
+  updateMeter(&setup->meter, output, frame_count, setup->info.channels);
 
-  sem_wait(&setup->control.mutex);
-  setup->control.writer_pos = writer_pos;
-  setup->control.reader_pos = reader_pos;
-  setup->control.new_data_flag = true;
-  sem_post(&setup->control.mutex);
+  // printf("writer: %d reader: %d frames %d\n", audio_control.writer_pos, reader_pos, frame_count);
+  publishWriterPos(setup, reader_pos, writer_pos);
 }
 
 // create jum_AudioSetup, initialize miniaudio context, enumerate devices
 jum_AudioSetup* jum_initAudio(ma_uint32 buffer_size, ma_uint32 predecode_bufs, ma_uint32 period) {
   ma_result result;
-  ma_resource_manager_config resource_manager_config;
   jum_AudioSetup* setup = (jum_AudioSetup*)malloc(sizeof(jum_AudioSetup));
   // allocate enough for max of 2 channels, if we are decoding 1 channel only half will be used
   setup->buffer.buf = (float*)malloc(buffer_size * 2 * sizeof(float));
+  setup->buffer.buf_s16 = NULL;
+  setup->buffer.format = ma_format_f32;
   setup->buffer.allocated_sz = buffer_size * 2;
   setup->predecode_bufs = predecode_bufs;
-  // allocate conversion buffer based on period * max possible bytes per frame (32 bits*2 channels)
-  setup->conversion_sz = period * sizeof(float) * 2;
-  setup->conversion_buf = (void*)malloc(period * sizeof(float) * 2);
+  // enough to replace everything predecoded after a seek
+  setup->prime.buf = (float*)malloc((predecode_bufs + 1) * period * 2 * sizeof(float));
+  setup->prime.frames = 0;
+  setup->prime.state = PRIME_IDLE;
 
   setup->mode = AUDIO_MODE_NONE;
-  setup->control.new_data_flag = false;
   setup->control.writer_pos = 0;
-  setup->control.reader_pos = 0;
+  setup->control.published = 0;
   setup->control.music_volume = 1;
   setup->control.other_volume = 1;
-  sem_init(&setup->control.mutex, 0, 1);
+  setup->control.monitor_volume = 1;
 
   setup->info.sample_rate = 0;
   setup->info.bytes_per_frame = 0;
   setup->info.channels = 0;
   setup->info.format = (ma_format)0;
   setup->info.period = period;
+  memset(&setup->meter, 0, sizeof(Meter));
   setup->capture_open = false;
   setup->playback_open = false;
 
   setup->num_sound_files = 0;
   setup->song_file.filepath = NULL;
+  setup->seeker_state = SEEKER_NONE;
+  setup->seeker_thread_open = false;
+  setup->song_streaming = false;
+  memset(&setup->waveform, 0, sizeof(Waveform));
+  memset(&setup->recorder, 0, sizeof(Recorder));
   for (ma_int32 i = 0; i < MAX_SOUND_FILES; i++) {
     setup->sound_files[i].filepath = NULL;
   }
 
+  // devices aren't enumerated until they're asked for, the default device doesn't need it
+  setup->playback_device_info = NULL;
+  setup->capture_device_info = NULL;
+  setup->playback_device_count = 0;
+  setup->capture_device_count = 0;
+  setup->devices_enumerated = false;
+  setup->devices_stale = false;
+  setup->push_next_frame = -1;
+
   result = ma_context_init(NULL, 0, NULL, &setup->context);
   if (result != MA_SUCCESS) {
     printf("Failed to initialize context.\n");
     return NULL;
   }
-  result = ma_context_get_devices(&setup->context, &setup->playback_device_info,
-                                  &setup->playback_device_count, &setup->capture_device_info,
-                                  &setup->capture_device_count);
+
+  // single job thread like miniaudio's default, jum_setLoadThreads adds more
+  result = initResourceManager(setup, 1);
   if (result != MA_SUCCESS) {
-    printf("Failed to retrieve device information.\n");
+    printf("Failed to initialize resource manager.");
     return NULL;
   }
+  ma_fence_init(&setup->load_fence);
+  setup->sound_loaded = NULL;
+  setup->sound_loaded_data = NULL;
+
+  return setup;
+}
+
+ma_result initResourceManager(jum_AudioSetup* setup, ma_uint32 job_threads) {
+  ma_resource_manager_config resource_manager_config;
 
+  if (job_threads < 1) {
+    job_threads = 1;
+  } else if (job_threads > MA_RESOURCE_MANAGER_MAX_JOB_THREAD_COUNT) {
+    job_threads = MA_RESOURCE_MANAGER_MAX_JOB_THREAD_COUNT;
+  }
   resource_manager_config = ma_resource_manager_config_init();
   resource_manager_config.decodedFormat = ma_format_f32;
   resource_manager_config.decodedChannels = 2;
   resource_manager_config.decodedSampleRate = 48000;
-  result = ma_resource_manager_init(&resource_manager_config, &setup->resource_manager);
+  resource_manager_config.jobThreadCount = job_threads;
+  return ma_resource_manager_init(&resource_manager_config, &setup->resource_manager);
+}
+
+// enumerate playback and capture devices into the setup's device lists. the last snapshot is kept
+// until refresh is set or an open device reports a change. the lists are owned by the context and
+// only valid until the next enumeration
+ma_int32 jum_getDevices(jum_AudioSetup* setup, bool refresh) {
+  ma_result result;
+
+  if (setup->devices_enumerated && !refresh &&
+      !__atomic_load_n(&setup->devices_stale, __ATOMIC_ACQUIRE)) {
+    return 0;
+  }
+  __atomic_store_n(&setup->devices_stale, false, __ATOMIC_RELEASE);
+  result = ma_context_get_devices(&setup->context, &setup->playback_device_info,
+                                  &setup->playback_device_count, &setup->capture_device_info,
+                                  &setup->capture_device_count);
   if (result != MA_SUCCESS) {
-    printf("Failed to initialize resource manager.");
-    return NULL;
+    printf("Failed to retrieve device information.\n");
+    setup->playback_device_count = 0;
+    setup->capture_device_count = 0;
+    setup->devices_enumerated = false;
+    return -1;
   }
+  setup->devices_enumerated = true;
+  return 0;
+}
 
-  return setup;
+// the set of devices may have changed when one is rerouted (e.g. default device unplugged)
+void deviceNotification(const ma_device_notification* notification) {
+  jum_AudioSetup* setup = (jum_AudioSetup*)notification->pDevice->pUserData;
+
+  if (notification->type == ma_device_notification_type_rerouted) {
+    __atomic_store_n(&setup->devices_stale, true, __ATOMIC_RELEASE);
+  }
 }
 
 void clearSongFile(jum_AudioSetup* setup) {
   if (setup->song_file.filepath != NULL) {
+    closeSongSeeker(setup);
+    closeWaveform(&setup->waveform);
     ma_sound_uninit(&setup->song_file.sound);
     free(setup->song_file.filepath);
     setup->song_file.filepath = NULL;
@@ -228,7 +581,10 @@ void clearSongFile(jum_AudioSetup* setup) {
 void jum_clearSoundFiles(jum_AudioSetup* setup) {
   for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
     if (setup->sound_files[i].filepath != NULL) {
-      ma_sound_uninit(&setup->sound_files[i].sound);
+      if (setup->playback_open) {
+        ma_sound_uninit(&setup->sound_files[i].sound);
+      }
+      ma_resource_manager_data_source_uninit(&setup->sound_files[i].source);
       free(setup->sound_files[i].filepath);
       setup->sound_files[i].filepath = NULL;
     }
@@ -238,24 +594,25 @@ void jum_clearSoundFiles(jum_AudioSetup* setup) {
 
 void jum_deinitAudio(jum_AudioSetup* setup) {
   if (setup != NULL) {
+    if (__atomic_load_n(&setup->recorder.state, __ATOMIC_ACQUIRE) != RECORD_IDLE) {
+      jum_stopRecording(setup);
+    }
     if (setup->capture_open) {
       ma_device_stop(&setup->capture_device);
       ma_device_uninit(&setup->capture_device);
     }
+    jum_clearSoundFiles(setup);  // sounds hold the resource manager even with playback closed
     if (setup->playback_open) {
       clearSongFile(setup);
-      jum_clearSoundFiles(setup);
-      ma_engine_stop(&setup->music_engine);
-      ma_engine_uninit(&setup->music_engine);
-      ma_engine_stop(&setup->other_engine);
-      ma_engine_uninit(&setup->other_engine);
-      ma_device_stop(&setup->playback_device);
-      ma_device_uninit(&setup->playback_device);
+      closePlaybackDevice(setup);
     }
+    closeWaveform(&setup->waveform);
     ma_context_uninit(&setup->context);
     ma_resource_manager_uninit(&setup->resource_manager);
+    ma_fence_uninit(&setup->load_fence);
     free(setup->buffer.buf);
-    free(setup->conversion_buf);
+    free(setup->buffer.buf_s16);
+    free(setup->prime.buf);
   }
   setup = NULL;
 }
@@ -263,6 +620,8 @@ void jum_deinitAudio(jum_AudioSetup* setup) {
 void closePlaybackDevice(jum_AudioSetup* setup) {
   if (setup->playback_open) {
     if (setup->song_file.filepath != NULL) {
+      closeSongSeeker(setup);
+      closeWaveform(&setup->waveform);  // reads through the resource manager
       ma_sound_stop(&setup->song_file.sound);
       ma_sound_uninit(&setup->song_file.sound);
     }
@@ -272,48 +631,77 @@ void closePlaybackDevice(jum_AudioSetup* setup) {
         ma_sound_uninit(&setup->sound_files[i].sound);
       }
     }
-    ma_engine_stop(&setup->music_engine);
-    ma_engine_uninit(&setup->music_engine);
-    ma_engine_stop(&setup->other_engine);
-    ma_engine_uninit(&setup->other_engine);
-    ma_device_stop(&setup->playback_device);
+    ma_engine_stop(&setup->engine);
+    ma_sound_group_uninit(&setup->music_group);
+    ma_sound_group_uninit(&setup->other_group);
+    ma_node_uninit(&setup->fft_tap, NULL);
+    ma_engine_uninit(&setup->engine);
     ma_device_uninit(&setup->playback_device);
     setup->playback_open = false;
   }
 }
 
 ma_int32 jum_openPlaybackDevice(jum_AudioSetup* setup, ma_int32 device_index) {
+  return openOutputDevice(setup, ma_device_type_playback, device_index, -1);
+}
+
+// single device for both capture and playback, use with AUDIO_MODE_DUPLEX to analyze and monitor
+// the input with effects mixed in. replaces the playback device, any separate capture device is
+// left alone
+ma_int32 jum_openDuplexDevice(jum_AudioSetup* setup, ma_int32 playback_index,
+                              ma_int32 capture_index) {
+  return openOutputDevice(setup, ma_device_type_duplex, playback_index, capture_index);
+}
+
+// open the device the engine outputs to, playback only or duplex
+ma_int32 openOutputDevice(jum_AudioSetup* setup, ma_device_type type, ma_int32 playback_index,
+                          ma_int32 capture_index) {
   ma_result result;
   ma_device_config device_config;
   ma_engine_config engine_config;
+  ma_node_config node_config;
+  ma_uint32 node_channels;
 
   // check if there is already an active device
   closePlaybackDevice(setup);
 
-  device_config = ma_device_config_init(ma_device_type_playback);
-  // if device index is valid then set it
-  if (device_index >= 0 && device_index < (ma_int32)setup->playback_device_count) {
-    device_config.playback.pDeviceID = &setup->playback_device_info[device_index].id;
+  device_config = ma_device_config_init(type);
+  // if device index is valid then set it, negative opens the default without enumerating
+  if (playback_index >= 0 && jum_getDevices(setup, false) == 0 &&
+      playback_index < (ma_int32)setup->playback_device_count) {
+    device_config.playback.pDeviceID = &setup->playback_device_info[playback_index].id;
+  }
+  if (type == ma_device_type_duplex) {
+    if (capture_index >= 0 && jum_getDevices(setup, false) == 0 &&
+        capture_index < (ma_int32)setup->capture_device_count) {
+      device_config.capture.pDeviceID = &setup->capture_device_info[capture_index].id;
+    }
+    // same layout as the output so input can be mixed straight in
+    device_config.capture.format = ma_format_f32;
+    device_config.capture.channels = 2;
   }
 
   // have to manually convert to float for fft so just use float for playback
   device_config.playback.format = ma_format_f32;
   device_config.playback.channels = 2;
   device_config.sampleRate = setup->resource_manager.config.decodedSampleRate;
-  device_config.dataCallback = playbackCallback;
+  device_config.dataCallback =
+      type == ma_device_type_duplex ? duplexCallback : playbackCallback;
+  device_config.notificationCallback = deviceNotification;
   device_config.pUserData = setup;
   device_config.periodSizeInFrames = setup->info.period;
   device_config.pulse.pStreamNamePlayback = stream_name;
 
   setup->info.channels = device_config.playback.channels;
   setup->info.sample_rate = device_config.sampleRate;
+  resetMeter(&setup->meter, setup->info.sample_rate);
   setup->info.format = ma_format_f32;
   setup->info.bytes_per_frame = ma_get_bytes_per_frame(setup->info.format, setup->info.channels);
 
   // set buffer size to appropriate value for given number of channels TODO look at how we are dealing with 1 vs 2 channels
   setup->buffer.sz =
       setup->info.channels == 2 ? setup->buffer.allocated_sz : setup->buffer.allocated_sz / 2;
-  memset(setup->buffer.buf, 0, setup->buffer.allocated_sz * sizeof(float));
+  clearAudioBuffer(&setup->buffer);
 
   result = ma_device_init(&setup->context, &device_config, &setup->playback_device);
   if (result != MA_SUCCESS) {
@@ -324,29 +712,58 @@ ma_int32 jum_openPlaybackDevice(jum_AudioSetup* setup, ma_int32 device_index) {
   engine_config = ma_engine_config_init();
   engine_config.pDevice = &setup->playback_device;
   engine_config.pResourceManager = &setup->resource_manager;
-  result = ma_engine_init(&engine_config, &setup->music_engine);
+  result = ma_engine_init(&engine_config, &setup->engine);
+  if (result != MA_SUCCESS) {
+    printf("Failed to initialize engine\n");
+    ma_device_uninit(&setup->playback_device);
+    return -1;
+  }
+
+  // music group -> fft tap -> endpoint, tap only runs while in playback mode
+  node_channels = setup->info.channels;
+  node_config = ma_node_config_init();
+  node_config.vtable = &fft_tap_vtable;
+  node_config.pInputChannels = &node_channels;
+  node_config.pOutputChannels = &node_channels;
+  node_config.initialState =
+      setup->mode == AUDIO_MODE_PLAYBACK ? ma_node_state_started : ma_node_state_stopped;
+  setup->fft_tap.setup = setup;
+  result = ma_node_init(ma_engine_get_node_graph(&setup->engine), &node_config, NULL,
+                        &setup->fft_tap);
   if (result != MA_SUCCESS) {
-    printf("Failed to initialize music engine\n");
+    printf("Failed to initialize fft tap node\n");
+    ma_engine_uninit(&setup->engine);
     ma_device_uninit(&setup->playback_device);
     return -1;
   }
-  result = ma_engine_init(&engine_config, &setup->other_engine);
+  ma_node_attach_output_bus(&setup->fft_tap, 0, ma_engine_get_endpoint(&setup->engine), 0);
+
+  result = ma_sound_group_init(&setup->engine, 0, NULL, &setup->music_group);
   if (result != MA_SUCCESS) {
-    printf("Failed to initialize other engine\n");
-    ma_engine_uninit(&setup->music_engine);
+    printf("Failed to initialize music group\n");
+    ma_node_uninit(&setup->fft_tap, NULL);
+    ma_engine_uninit(&setup->engine);
     ma_device_uninit(&setup->playback_device);
     return -1;
   }
+  ma_node_attach_output_bus(&setup->music_group, 0, &setup->fft_tap, 0);
 
-  result = ma_engine_start(&setup->music_engine);
+  result = ma_sound_group_init(&setup->engine, 0, NULL, &setup->other_group);
   if (result != MA_SUCCESS) {
-    printf("Failed to start music engine \n");
+    printf("Failed to initialize other group\n");
+    ma_sound_group_uninit(&setup->music_group);
+    ma_node_uninit(&setup->fft_tap, NULL);
+    ma_engine_uninit(&setup->engine);
+    ma_device_uninit(&setup->playback_device);
     return -1;
   }
 
-  result = ma_engine_start(&setup->other_engine);
+  ma_node_set_output_bus_volume(&setup->fft_tap, 0, setup->control.music_volume);
+  ma_sound_group_set_volume(&setup->other_group, setup->control.other_volume);
+
+  result = ma_engine_start(&setup->engine);
   if (result != MA_SUCCESS) {
-    printf("Failed to start other engine \n");
+    printf("Failed to start engine \n");
     return -1;
   }
 
@@ -354,37 +771,34 @@ ma_int32 jum_openPlaybackDevice(jum_AudioSetup* setup, ma_int32 device_index) {
 
   // load songs back after changing device
   if (setup->song_file.filepath != NULL) {
-    result = ma_sound_init_from_file(&setup->music_engine, setup->song_file.filepath, SOUND_FLAGS,
-                                     NULL, NULL, &setup->song_file.sound);
+    result = ma_sound_init_from_file(&setup->engine, setup->song_file.filepath, SOUND_FLAGS,
+                                     &setup->music_group, NULL, &setup->song_file.sound);
     if (result != MA_SUCCESS) {
       printf("WARNING: Failed to load sound \"%s\"", setup->song_file.filepath);
+      free(setup->song_file.filepath);
       setup->song_file.filepath = NULL;
+    } else {
+      openSongSeeker(setup);
+      openWaveform(setup);
     }
   }
   for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
     if (setup->sound_files[i].filepath != NULL) {
-      result = ma_sound_init_from_file(&setup->other_engine, setup->sound_files[i].filepath,
-                                       SOUND_FLAGS, NULL, NULL, &setup->sound_files[i].sound);
+      result = initSoundFile(setup, &setup->sound_files[i], setup->sound_files[i].filepath);
       if (result != MA_SUCCESS) {
         printf("WARNING: Failed to load sound \"%s\"", setup->sound_files[i].filepath);
+        ma_resource_manager_data_source_uninit(&setup->sound_files[i].source);
+        free(setup->sound_files[i].filepath);
         setup->sound_files[i].filepath = NULL;
       }
     }
   }
 
 #ifdef JUMAUDIO_DEBUG
-  char* selected_device_name;
-  if (device_index >= 0 && device_index < (ma_int32)setup->playback_device_count) {
-    selected_device_name = setup->playback_device_info[device_index].name;
-  } else {
-    for (ma_uint32 i = 0; i < setup->playback_device_count; i++) {
-      if (setup->playback_device_info[i].isDefault) {
-        selected_device_name = setup->playback_device_info[i].name;
-      }
-    }
-  }
+  // name from the opened device itself so the default device doesn't need enumerating
+  const char* selected_device_name = setup->playback_device.playback.name;
 
-  printf("Starting playback on device [%d]'%s'\n", device_index, selected_device_name);
+  printf("Starting playback on device [%d]'%s'\n", playback_index, selected_device_name);
   jum_printAudioInfo(setup->info);
 #endif
 
@@ -402,24 +816,166 @@ ma_int32 jum_loadSound(jum_AudioSetup* setup, const char* filepath) {
     return -2;
   }
 
-  // first avaialable slot
+  // first avaialable slot, decoding starts now even if the playback device isn't open yet
   sound_file = &setup->sound_files[index];
-  sound_file->filepath = NULL;
-  if (setup->playback_open) {
-    result = ma_sound_init_from_file(&setup->other_engine, filepath, SOUND_FLAGS, NULL, NULL,
-                                     &sound_file->sound);
+  sound_file->filepath = strdup(filepath);
+  result = queueSoundFile(setup, index);
+  if (result == MA_SUCCESS && setup->playback_open) {
+    result = initSoundFile(setup, sound_file, filepath);
     if (result != MA_SUCCESS) {
-      printf("WARNING: Failed to load sound \"%s\"", filepath);
-      return -1;
+      ma_resource_manager_data_source_uninit(&sound_file->source);
     }
   }
-
-  sound_file->filepath = strdup(filepath);
+  if (result != MA_SUCCESS) {
+    printf("WARNING: Failed to load sound \"%s\"", filepath);
+    free(sound_file->filepath);
+    sound_file->filepath = NULL;
+    return -1;
+  }
 
   setup->num_sound_files++;
   return index;
 }
 
+// playable sound for sound_file, shares the decoded buffer its source already holds (or is still
+// decoding) since the resource manager keeps one buffer per file
+ma_result initSoundFile(jum_AudioSetup* setup, SoundFile* sound_file, const char* filepath) {
+  return ma_sound_init_from_file(&setup->engine, filepath, SOUND_FLAGS, &setup->other_group, NULL,
+                                 &sound_file->sound);
+}
+
+// start decoding a sound on the resource manager's job threads and return without waiting, the
+// source holds the decoded buffer until the sound is cleared so opening playback doesn't reload it
+ma_result queueSoundFile(jum_AudioSetup* setup, ma_int32 handle) {
+  SoundFile* sound_file = &setup->sound_files[handle];
+  ma_resource_manager_pipeline_notifications notifications;
+
+  sound_file->load.callbacks.onSignal = soundLoaded;
+  sound_file->load.setup = setup;
+  sound_file->load.handle = handle;
+  notifications = ma_resource_manager_pipeline_notifications_init();
+  notifications.done.pNotification = &sound_file->load;
+  notifications.done.pFence = &setup->load_fence;
+  return ma_resource_manager_data_source_init(&setup->resource_manager, sound_file->filepath,
+                                              SOUND_SOURCE_FLAGS, &notifications,
+                                              &sound_file->source);
+}
+
+// runs on a job thread once a sound is decoded or has failed
+void soundLoaded(ma_async_notification* notification) {
+  SoundLoad* load = (SoundLoad*)notification;
+  jum_AudioSetup* setup = load->setup;
+
+  if (setup->sound_loaded != NULL) {
+    setup->sound_loaded(load->handle, soundStatus(&setup->sound_files[load->handle]),
+                        setup->sound_loaded_data);
+  }
+}
+
+// handle of an already loaded sound with the same filepath, -1 if there isn't one
+ma_int32 findSoundFile(jum_AudioSetup* setup, const char* filepath) {
+  for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
+    if (setup->sound_files[i].filepath != NULL &&
+        strcmp(setup->sound_files[i].filepath, filepath) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// queue a batch of sounds to load in parallel and return immediately, use jum_getSoundStatus,
+// jum_waitForSounds or jum_setSoundLoadedCallback to find out when they're ready. repeated paths
+// share a handle, handles[i] is negative if paths[i] failed. returns how many failed
+ma_int32 jum_loadSounds(jum_AudioSetup* setup, const char* const* paths, ma_int32 count,
+                        ma_int32* handles) {
+  ma_int32 failed = 0;
+
+  for (ma_int32 i = 0; i < count; i++) {
+    handles[i] = findSoundFile(setup, paths[i]);
+    if (handles[i] < 0) {
+      handles[i] = jum_loadSound(setup, paths[i]);
+    }
+    if (handles[i] < 0) {
+      failed++;
+    }
+  }
+  return failed;
+}
+
+// 0 once the sound is decoded and ready to play, 1 while still loading, negative for an invalid
+// handle or failed load. sounds load whether or not the playback device is open
+ma_int32 jum_getSoundStatus(jum_AudioSetup* setup, ma_int32 handle) {
+  if (handle < 0 || handle >= setup->num_sound_files ||
+      setup->sound_files[handle].filepath == NULL) {
+    return -1;
+  }
+  return soundStatus(&setup->sound_files[handle]);
+}
+
+// can be signalled before jum_loadSound returns the handle, so no checks against the setup
+ma_int32 soundStatus(SoundFile* sound_file) {
+  ma_result result = ma_resource_manager_data_source_result(&sound_file->source);
+  if (result == MA_BUSY) {
+    return 1;
+  }
+  return result == MA_SUCCESS ? 0 : -2;
+}
+
+// block until every sound queued so far has finished loading
+void jum_waitForSounds(jum_AudioSetup* setup) {
+  ma_fence_wait(&setup->load_fence);
+}
+
+// callback for each sound as it finishes loading (or fails), NULL to stop. called on a resource
+// manager job thread so set it before queueing the sounds it should see
+void jum_setSoundLoadedCallback(jum_AudioSetup* setup, jum_SoundLoaded callback, void* user_data) {
+  setup->sound_loaded = callback;
+  setup->sound_loaded_data = user_data;
+}
+
+// number of job threads decoding sounds, defaults to 1. e.g. the number of cores lets a batch from
+// jum_loadSounds decode in parallel. the resource manager is recreated so this can only be changed
+// while the playback device is closed, sounds already queued are queued again on the new one
+ma_int32 jum_setLoadThreads(jum_AudioSetup* setup, ma_uint32 count) {
+  ma_result result;
+  ma_uint32 old_count;
+  ma_int32 ret = 0;
+
+  if (setup->playback_open) {
+    printf("WARNING: attempting to change load threads while playback device is open\n");
+    return -2;
+  }
+  for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
+    if (setup->sound_files[i].filepath != NULL) {
+      ma_resource_manager_data_source_uninit(&setup->sound_files[i].source);
+    }
+  }
+  old_count = setup->resource_manager.config.jobThreadCount;
+  ma_resource_manager_uninit(&setup->resource_manager);
+  result = initResourceManager(setup, count);
+  if (result != MA_SUCCESS) {
+    printf("Failed to initialize resource manager.");
+    ret = -1;
+    // put the old one back so the setup is still usable
+    if (initResourceManager(setup, old_count) != MA_SUCCESS) {
+      printf("WARNING: failed to restore resource manager\n");
+      for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
+        free(setup->sound_files[i].filepath);
+        setup->sound_files[i].filepath = NULL;
+      }
+      return -1;
+    }
+  }
+  for (ma_int32 i = 0; i < setup->num_sound_files; i++) {
+    if (setup->sound_files[i].filepath != NULL && queueSoundFile(setup, i) != MA_SUCCESS) {
+      printf("WARNING: Failed to load sound \"%s\"", setup->sound_files[i].filepath);
+      free(setup->sound_files[i].filepath);
+      setup->sound_files[i].filepath = NULL;
+    }
+  }
+  return ret;
+}
+
 ma_int32 jum_playSound(jum_AudioSetup* setup, ma_int32 handle, float repeat_delay) {
   float cursor;
   SoundFile* sound_file;
@@ -459,22 +1015,25 @@ ma_int32 jum_playSong(jum_AudioSetup* setup, const char* filepath) {
   }
 
   if (setup->song_file.filepath != NULL) {
+    closeSongSeeker(setup);
     ma_sound_stop(&setup->song_file.sound);
     ma_sound_uninit(&setup->song_file.sound);
     free(setup->song_file.filepath);
     setup->song_file.filepath = NULL;
   }
 
-  result = ma_sound_init_from_file(&setup->music_engine, filepath, SOUND_FLAGS, NULL, NULL,
-                                   &setup->song_file.sound);
+  result = ma_sound_init_from_file(&setup->engine, filepath, SOUND_FLAGS, &setup->music_group,
+                                   NULL, &setup->song_file.sound);
   if (result != MA_SUCCESS) {
     printf("WARNING: Failed to load sound \"%s\"", setup->song_file.filepath);
     return -1;
   }
 
   setup->song_file.filepath = strdup(filepath);
+  openSongSeeker(setup);
+  openWaveform(setup);
 
-  memset(setup->buffer.buf, 0, setup->buffer.allocated_sz * sizeof(float));
+  clearAudioBuffer(&setup->buffer);
   // start song
   result = ma_sound_start(&setup->song_file.sound);
   if (result != MA_SUCCESS) {
@@ -491,7 +1050,7 @@ float jum_getSongLength(jum_AudioSetup* setup) {
   if (setup->song_file.filepath == NULL) {
     return 0;
   }
-  result = ma_sound_get_length_in_seconds(&setup->song_file.sound, &length);
+  result = ma_sound_get_length_in_seconds(songSound(setup), &length);
   if (result != MA_SUCCESS) {
     return 0;
   }
@@ -504,7 +1063,7 @@ float jum_getSongCursor(jum_AudioSetup* setup) {
   if (setup->song_file.filepath == NULL) {
     return 0;
   }
-  result = ma_sound_get_cursor_in_seconds(&setup->song_file.sound, &cursor);
+  result = ma_sound_get_cursor_in_seconds(songSound(setup), &cursor);
   if (result != MA_SUCCESS) {
     return 0;
   }
@@ -515,348 +1074,2707 @@ bool jum_isSongFinished(jum_AudioSetup* setup) {
   if (setup->song_file.filepath == NULL) {
     return false;
   }
-  return ma_sound_at_end(&setup->song_file.sound);
-}
-
-void closeCaptureDevice(jum_AudioSetup* setup) {
-  if (setup->capture_open) {
-    ma_device_stop(&setup->capture_device);
-    ma_device_uninit(&setup->capture_device);
-    setup->capture_open = false;
-  }
+  return ma_sound_at_end(songSound(setup));
 }
 
-ma_int32 jum_openCaptureDevice(jum_AudioSetup* setup, ma_int32 device_index) {
+// jump to seconds into the current song. what was already predecoded is replaced with audio from
+// the target, so both what's heard and what's analyzed move right away. positions the background
+// decode hasn't reached yet are streamed from the seek index until the next seek
+ma_int32 jum_seekSong(jum_AudioSetup* setup, float seconds) {
+  ma_resource_manager_data_source* data_source;
+  ma_uint64 target, cursor, available, frames_read, resume_frame;
+  ma_uint32 prime_frames, src_rate;
+  ma_sound* sound;
   ma_result result;
-  ma_device_config device_config;
-
-  // check if there is already an active device, if there is then stop it and start a new one
-  closeCaptureDevice(setup);
+  bool playing;
+  bool decoded = true;
 
-  device_config = ma_device_config_init(ma_device_type_capture);
-  if (device_index >= 0 && device_index < (ma_int32)setup->capture_device_count) {
-    device_config.capture.pDeviceID = &setup->capture_device_info[device_index].id;
+  if (!setup->playback_open) {
+    printf("WARNING: attempting to seek song without playback device open\n");
+    return -2;
   }
-  device_config.capture.format = ma_format_f32;
-  device_config.capture.channels = 2;
-  device_config.sampleRate = 44100;
-  device_config.dataCallback = captureCallback;
-  device_config.pUserData = setup;
-
-  setup->info.channels = device_config.capture.channels;
-  setup->info.sample_rate = device_config.sampleRate;
-  setup->info.format = device_config.capture.format;
-  setup->info.bytes_per_frame = ma_get_bytes_per_frame(setup->info.format, setup->info.channels);
+  if (setup->song_file.filepath == NULL) {
+    return -2;
+  }
+  target = (ma_uint64)((seconds < 0 ? 0 : seconds) * setup->info.sample_rate);
+  ma_sound_get_data_format(&setup->song_file.sound, NULL, NULL, &src_rate, NULL, 0);
 
-  // set buffer size to appropriate value for 2 channels
-  setup->buffer.sz = setup->buffer.allocated_sz;
-  memset(setup->buffer.buf, 0, setup->buffer.allocated_sz * sizeof(float));
+  if (__atomic_load_n(&setup->seeker_state, __ATOMIC_ACQUIRE) != SEEKER_READY) {
+    // no seek index (yet), the decoded sound waits for the decode to reach the target
+    result = ma_sound_seek_to_pcm_frame(&setup->song_file.sound,
+                                        target * src_rate / setup->info.sample_rate);
+    return result == MA_SUCCESS ? 0 : -1;
+  }
 
-  result = ma_device_init(&setup->context, &device_config, &setup->capture_device);
-  if (result != MA_SUCCESS) {
-    printf("Failed to open device.\n");
-    return -1;
+  // audio thread is done with the seeker once any pending prime and the stream are gone
+  playing = ma_sound_is_playing(songSound(setup));
+  cancelPrime(&setup->prime);
+  if (setup->song_streaming) {
+    ma_sound_uninit(&setup->song_stream);
+    setup->song_streaming = false;
   }
 
-  result = ma_device_start(&setup->capture_device);
+  result = ma_decoder_seek_to_pcm_frame(&setup->song_seeker, target);
   if (result != MA_SUCCESS) {
-    ma_device_uninit(&setup->capture_device);
-    printf("Failed to start device.\n");
+    printf("WARNING: Failed to seek \"%s\"\n", setup->song_file.filepath);
     return -1;
   }
-
-  setup->capture_open = true;
-
+  // tap only runs in playback mode, otherwise there is nothing predecoded to replace
+  prime_frames = 0;
+  if (setup->mode == AUDIO_MODE_PLAYBACK) {
+    prime_frames = (setup->predecode_bufs + 1) * setup->info.period;
+  }
+  frames_read = 0;
+  if (prime_frames > 0) {
+    ma_decoder_read_pcm_frames(&setup->song_seeker, setup->prime.buf, prime_frames, &frames_read);
+    memset(&setup->prime.buf[frames_read * setup->info.channels], 0,
+           (prime_frames - frames_read) * setup->info.channels * sizeof(float));
+  }
+  resume_frame = (target + prime_frames) * src_rate / setup->info.sample_rate;
+
+  // the decoded sound is only usable if the background decode is already past the resume point
+  data_source = setup->song_file.sound.pResourceManagerDataSource;
+  if (data_source != NULL && ma_resource_manager_data_source_result(data_source) == MA_BUSY) {
+    ma_sound_get_cursor_in_pcm_frames(&setup->song_file.sound, &cursor);
+    ma_resource_manager_data_source_get_available_frames(data_source, &available);
+    decoded = resume_frame + setup->info.period < cursor + available;
+  }
+
+  sound = &setup->song_file.sound;
+  if (!decoded) {
+    // stream the rest through the resource manager, it reads and seeks on its job threads so the
+    // audio thread never decodes. decoded at the same rate as the song so src_rate still applies
+    result = ma_sound_init_from_file(&setup->engine, setup->song_file.filepath, SONG_STREAM_FLAGS,
+                                     &setup->music_group, NULL, &setup->song_stream);
+    if (result == MA_SUCCESS) {
+      ma_sound_stop(&setup->song_file.sound);
+      setup->song_streaming = true;
+      sound = &setup->song_stream;
+    } else {
+      printf("WARNING: Failed to stream \"%s\", waiting for decode\n", setup->song_file.filepath);
+    }
+  }
+
+  if (prime_frames > 0) {
+    setup->prime.frames = prime_frames;
+    setup->prime.target = target;
+    setup->prime.sound = sound;
+    setup->prime.src_rate = src_rate;
+    __atomic_store_n(&setup->prime.state, PRIME_READY, __ATOMIC_RELEASE);
+  } else {
+    ma_sound_seek_to_pcm_frame(sound, target * src_rate / setup->info.sample_rate);
+  }
+  if (playing) {
+    ma_sound_start(sound);
+  }
+  return 0;
+}
+
+// open the song a second time for seeking on its own thread, building an mp3's seek table scans the
+// whole file. seeks before it's ready wait for the decode instead
+void openSongSeeker(jum_AudioSetup* setup) {
+  setup->song_streaming = false;
+  __atomic_store_n(&setup->seeker_state, SEEKER_BUILDING, __ATOMIC_RELEASE);
+  setup->seeker_thread_open =
+      pthread_create(&setup->seeker_thread, NULL, buildSongSeeker, setup) == 0;
+  if (!setup->seeker_thread_open) {
+    printf("WARNING: Failed to build seek index for \"%s\"\n", setup->song_file.filepath);
+    __atomic_store_n(&setup->seeker_state, SEEKER_NONE, __ATOMIC_RELEASE);
+  }
+}
+
+// mp3s get a seek table built from a scan of the file, flac and wav seek with their own
+void* buildSongSeeker(void* arg) {
+  jum_AudioSetup* setup = (jum_AudioSetup*)arg;
+  ma_decoder_config config;
+  ma_result result;
+
+  config = ma_decoder_config_init(ma_format_f32, setup->info.channels, setup->info.sample_rate);
+  config.seekPointCount = SEEK_POINTS;
+  result = ma_decoder_init_file(setup->song_file.filepath, &config, &setup->song_seeker);
+  if (result != MA_SUCCESS) {
+    printf("WARNING: Failed to build seek index for \"%s\"\n", setup->song_file.filepath);
+  }
+  __atomic_store_n(&setup->seeker_state, result == MA_SUCCESS ? SEEKER_READY : SEEKER_NONE,
+                   __ATOMIC_RELEASE);
+  return NULL;
+}
+
+void closeSongSeeker(jum_AudioSetup* setup) {
+  cancelPrime(&setup->prime);
+  if (setup->song_streaming) {
+    ma_sound_uninit(&setup->song_stream);
+    setup->song_streaming = false;
+  }
+  if (setup->seeker_thread_open) {
+    pthread_join(setup->seeker_thread, NULL);
+    setup->seeker_thread_open = false;
+  }
+  if (__atomic_load_n(&setup->seeker_state, __ATOMIC_ACQUIRE) == SEEKER_READY) {
+    ma_decoder_uninit(&setup->song_seeker);
+  }
+  __atomic_store_n(&setup->seeker_state, SEEKER_NONE, __ATOMIC_RELEASE);
+}
+
+// take back a prime the tap hasn't applied yet, waits out one that is being applied
+void cancelPrime(SeekPrime* prime) {
+  ma_int32 expected = PRIME_READY;
+
+  while (!__atomic_compare_exchange_n(&prime->state, &expected, PRIME_IDLE, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE) &&
+         expected != PRIME_IDLE) {
+    expected = PRIME_READY;
+  }
+}
+
+// fill width columns summarizing the whole song for drawing an overview, each from the coarsest
+// level with at least one entry per column. first summarizes, on this thread, whatever the
+// background decode has added since the last call. returns how many columns are ready
+ma_int32 jum_getWaveform(jum_AudioSetup* setup, ma_int32 width, jum_WaveformPeak* peaks) {
+  Waveform* waveform = &setup->waveform;
+  const jum_WaveformPeak* entries;
+  ma_uint64 total, entry_frames, start, end, j;
+  ma_int32 level = 0;
+  ma_int32 i;
+  float mean_sq;
+
+  if (width <= 0) {
+    return 0;
+  }
+  updateWaveform(waveform);
+  total = waveform->total_frames;
+  if (total == 0) {
+    return 0;
+  }
+  while (level + 1 < WAVEFORM_LEVELS && waveform->counts[level + 1] > 0 &&
+         ((ma_uint64)WAVEFORM_BASE << (level + 1)) <= total / width) {
+    level++;
+  }
+  entries = waveform->levels[level];
+  entry_frames = (ma_uint64)WAVEFORM_BASE << level;
+
+  for (i = 0; i < width; i++) {
+    start = total * i / width / entry_frames;
+    end = (total * (i + 1) / width + entry_frames - 1) / entry_frames;
+    if (end <= start) {
+      end = start + 1;
+    }
+    if (end > waveform->counts[level]) {
+      break;  // not decoded this far yet
+    }
+    peaks[i] = entries[start];
+    mean_sq = entries[start].rms;
+    for (j = start + 1; j < end; j++) {
+      peaks[i].min = fminf(peaks[i].min, entries[j].min);
+      peaks[i].max = fmaxf(peaks[i].max, entries[j].max);
+      mean_sq += entries[j].rms;
+    }
+    peaks[i].rms = sqrtf(mean_sq / (end - start));
+  }
+  return i;
+}
+
+// start summarizing the song that was just loaded, reading from a copy of its data source shares
+// the decoded audio instead of loading the file again
+void openWaveform(jum_AudioSetup* setup) {
+  Waveform* waveform = &setup->waveform;
+  ma_result result;
+
+  closeWaveform(waveform);
+  result = ma_resource_manager_data_source_init_copy(
+      &setup->resource_manager, setup->song_file.sound.pResourceManagerDataSource,
+      &waveform->source);
+  if (result != MA_SUCCESS) {
+    printf("WARNING: Failed to open \"%s\" for waveform\n", setup->song_file.filepath);
+    return;
+  }
+  waveform->open = true;
+}
+
+void closeWaveform(Waveform* waveform) {
+  if (waveform->open) {
+    ma_resource_manager_data_source_uninit(&waveform->source);
+  }
+  for (ma_int32 i = 0; i < WAVEFORM_LEVELS; i++) {
+    free(waveform->levels[i]);
+  }
+  memset(waveform, 0, sizeof(Waveform));
+}
+
+// summarize whatever the background decode has finished since the last call. runs on the thread
+// calling jum_getWaveform, the decode itself doesn't summarize anything
+void updateWaveform(Waveform* waveform) {
+  float frames[WAVEFORM_CHUNK * 2];
+  jum_WaveformPeak* pending = &waveform->pending;
+  ma_uint64 frames_read, i;
+  ma_int32 level;
+  bool decoded;
+  float sample;
+
+  if (!waveform->open || waveform->finished) {
+    return;
+  }
+  if (waveform->total_frames == 0) {
+    ma_resource_manager_data_source_get_length_in_pcm_frames(&waveform->source,
+                                                             &waveform->total_frames);
+  }
+  // checked before reading, a short read after the decode finished means the end was reached
+  decoded = ma_resource_manager_data_source_result(&waveform->source) != MA_BUSY;
+
+  do {
+    frames_read = 0;
+    ma_resource_manager_data_source_read_pcm_frames(&waveform->source, frames, WAVEFORM_CHUNK,
+                                                    &frames_read);
+    for (i = 0; i < frames_read; i++) {
+      // resource manager decodes everything to 2 channels
+      sample = (frames[i * 2] + frames[i * 2 + 1]) * 0.5F;
+      if (waveform->pending_frames == 0) {
+        pending->min = sample;
+        pending->max = sample;
+        pending->rms = 0;
+      }
+      pending->min = fminf(pending->min, sample);
+      pending->max = fmaxf(pending->max, sample);
+      pending->rms += sample * sample;
+      if (++waveform->pending_frames == WAVEFORM_BASE) {
+        pending->rms /= WAVEFORM_BASE;
+        pushWaveformEntry(waveform, 0, pending);
+        waveform->pending_frames = 0;
+      }
+    }
+    waveform->summarized += frames_read;
+  } while (frames_read == WAVEFORM_CHUNK);
+
+  if (!decoded) {
+    return;
+  }
+  if (waveform->pending_frames > 0) {
+    pending->rms /= waveform->pending_frames;
+    pushWaveformEntry(waveform, 0, pending);
+    waveform->pending_frames = 0;
+  }
+  // carry unpaired last entries up so every level covers the whole song
+  for (level = 0; level + 1 < WAVEFORM_LEVELS && waveform->counts[level] > 1; level++) {
+    if (waveform->counts[level] % 2 == 1) {
+      pushWaveformEntry(waveform, level + 1,
+                        &waveform->levels[level][waveform->counts[level] - 1]);
+    }
+  }
+  waveform->total_frames = waveform->summarized;
+  waveform->finished = true;
+}
+
+// append to a level, every second entry also adds their combination to the level above
+void pushWaveformEntry(Waveform* waveform, ma_int32 level, const jum_WaveformPeak* entry) {
+  jum_WaveformPeak* pair;
+  jum_WaveformPeak merged;
+  jum_WaveformPeak* grown;
+  ma_uint64 capacity;
+
+  if (waveform->counts[level] == waveform->capacity[level]) {
+    // sized for the whole song up front when its length is known, otherwise grows as it decodes
+    capacity = waveform->total_frames / ((ma_uint64)WAVEFORM_BASE << level) + 1;
+    if (capacity <= waveform->capacity[level]) {
+      capacity = waveform->capacity[level] * 2;
+    }
+    grown = (jum_WaveformPeak*)realloc(waveform->levels[level],
+                                       capacity * sizeof(jum_WaveformPeak));
+    if (grown == NULL) {
+      printf("WARNING: Failed to allocate waveform level %d\n", level);
+      return;
+    }
+    waveform->levels[level] = grown;
+    waveform->capacity[level] = capacity;
+  }
+  waveform->levels[level][waveform->counts[level]++] = *entry;
+
+  if (waveform->counts[level] % 2 == 0 && level + 1 < WAVEFORM_LEVELS) {
+    pair = &waveform->levels[level][waveform->counts[level] - 2];
+    merged.min = fminf(pair[0].min, pair[1].min);
+    merged.max = fmaxf(pair[0].max, pair[1].max);
+    merged.rms = (pair[0].rms + pair[1].rms) * 0.5F;
+    pushWaveformEntry(waveform, level + 1, &merged);
+  }
+}
+
+// whichever sound is currently playing the song
+ma_sound* songSound(jum_AudioSetup* setup) {
+  return setup->song_streaming ? &setup->song_stream : &setup->song_file.sound;
+}
+
+void closeCaptureDevice(jum_AudioSetup* setup) {
+  if (setup->capture_open) {
+    ma_device_stop(&setup->capture_device);
+    ma_device_uninit(&setup->capture_device);
+    setup->capture_open = false;
+  }
+}
+
+ma_int32 jum_openCaptureDevice(jum_AudioSetup* setup, ma_int32 device_index) {
+  ma_result result;
+  ma_device_config device_config;
+
+  // check if there is already an active device, if there is then stop it and start a new one
+  closeCaptureDevice(setup);
+
+  device_config = ma_device_config_init(ma_device_type_capture);
+  if (device_index >= 0 && jum_getDevices(setup, false) == 0 &&
+      device_index < (ma_int32)setup->capture_device_count) {
+    device_config.capture.pDeviceID = &setup->capture_device_info[device_index].id;
+  }
+  device_config.capture.format = ma_format_f32;
+  device_config.capture.channels = 2;
+  device_config.sampleRate = 44100;
+  device_config.dataCallback = captureCallback;
+  device_config.notificationCallback = deviceNotification;
+  device_config.pUserData = setup;
+
+  setup->info.channels = device_config.capture.channels;
+  setup->info.sample_rate = device_config.sampleRate;
+  resetMeter(&setup->meter, setup->info.sample_rate);
+  setup->info.format = device_config.capture.format;
+  setup->info.bytes_per_frame = ma_get_bytes_per_frame(setup->info.format, setup->info.channels);
+
+  // set buffer size to appropriate value for 2 channels
+  setup->buffer.sz = setup->buffer.allocated_sz;
+  clearAudioBuffer(&setup->buffer);
+
+  result = ma_device_init(&setup->context, &device_config, &setup->capture_device);
+  if (result != MA_SUCCESS) {
+    printf("Failed to open device.\n");
+    return -1;
+  }
+
+  result = ma_device_start(&setup->capture_device);
+  if (result != MA_SUCCESS) {
+    ma_device_uninit(&setup->capture_device);
+    printf("Failed to start device.\n");
+    return -1;
+  }
+
+  setup->capture_open = true;
+
 #ifdef JUMAUDIO_DEBUG
-  char* selected_device_name;
-  if (device_index >= 0 && device_index < (ma_int32)setup->capture_device_count) {
-    selected_device_name = setup->capture_device_info[device_index].name;
+  // name from the opened device itself so the default device doesn't need enumerating
+  const char* selected_device_name = setup->capture_device.capture.name;
+
+  printf("Starting capture of device [%d]'%s'\n", device_index, selected_device_name);
+  jum_printAudioInfo(setup->info);
+#endif
+
+  return 0;
+}
+
+// analyze samples the caller decodes itself instead of a device, stops any device writing into
+// the audio buffer. pushed samples are stored as 2 channel frames at sample_rate
+void jum_openPushInput(jum_AudioSetup* setup, ma_uint32 sample_rate) {
+  jum_setFFTMode(setup, AUDIO_MODE_PUSH);
+
+  setup->info.channels = 2;
+  setup->info.sample_rate = sample_rate;
+  resetMeter(&setup->meter, setup->info.sample_rate);
+  setup->info.format = ma_format_f32;
+  setup->info.bytes_per_frame = ma_get_bytes_per_frame(setup->info.format, setup->info.channels);
+
+  setup->buffer.sz = setup->buffer.allocated_sz;
+  clearAudioBuffer(&setup->buffer);
+  publishWriterPos(setup, 0, 0);
+  setup->push_next_frame = -1;
+}
+
+// write count interleaved frames of any format and channel count into the audio buffer without
+// blocking, from a single producer thread. timestamp is the frame index of the first frame at the
+// push input sample rate, gaps are filled with silence and overlaps dropped so the analysis stays
+// in time. negative timestamp assumes frames follow on from the last push. returns frames written
+ma_int32 jum_pushSamples(jum_AudioSetup* setup, const void* frames, ma_uint32 count,
+                         ma_format format, ma_uint32 channels, ma_int64 timestamp) {
+  TRACE_SCOPE(__func__);
+  static const float silence[PUSH_CHUNK_SAMPLES] = {0};
+  ma_int64 gap;
+  ma_uint32 frame_bytes, chunk;
+
+  if (setup->mode != AUDIO_MODE_PUSH) {
+    printf("WARNING: attempting to push samples without opening push input\n");
+    return -2;
+  }
+  if (channels == 0 || channels * 2 > PUSH_CHUNK_SAMPLES) {
+    return -1;
+  }
+  frame_bytes = ma_get_bytes_per_frame(format, channels);
+
+  if (timestamp >= 0 && setup->push_next_frame >= 0) {
+    gap = timestamp - setup->push_next_frame;
+    if (gap < 0) {
+      // already have these frames
+      if ((ma_uint64)-gap >= count) {
+        return 0;
+      }
+      frames = (const char*)frames + (-gap) * frame_bytes;
+      count -= (ma_uint32)-gap;
+      timestamp -= gap;
+    } else if (gap > 0) {
+      // anything more than the buffer holds would just be overwritten
+      if (gap > setup->buffer.sz / 2) {
+        gap = setup->buffer.sz / 2;
+      }
+      for (; gap > 0; gap -= chunk) {
+        chunk = gap > PUSH_CHUNK_SAMPLES / 2 ? PUSH_CHUNK_SAMPLES / 2 : (ma_uint32)gap;
+        writeCapturedFrames(setup, silence, chunk);
+      }
+    }
+  }
+  if (timestamp >= 0) {
+    setup->push_next_frame = timestamp + count;
+  } else if (setup->push_next_frame >= 0) {
+    setup->push_next_frame += count;
+  }
+
+  pushStereoFrames(setup, frames, count, format, channels);
+  return (ma_int32)count;
+}
+
+// convert to 2 channel f32 in chunks on the stack, mono is duplicated, extra channels dropped
+void pushStereoFrames(jum_AudioSetup* setup, const void* frames, ma_uint32 count,
+                      ma_format format, ma_uint32 channels) {
+  float converted[PUSH_CHUNK_SAMPLES];
+  float stereo[PUSH_CHUNK_SAMPLES];
+  const float* in;
+  ma_uint32 chunk_frames, chunk, max_frames, i;
+
+  // a single write has to fit in the buffer, anything older than that is overwritten anyway
+  max_frames = setup->buffer.sz / 2;
+
+  // already in the buffer's layout, no copy needed
+  if (format == ma_format_f32 && channels == 2) {
+    while (count > 0) {
+      chunk = count > max_frames ? max_frames : count;
+      writeCapturedFrames(setup, (const float*)frames, chunk);
+      frames = (const float*)frames + chunk * 2;
+      count -= chunk;
+    }
+    return;
+  }
+
+  chunk_frames = PUSH_CHUNK_SAMPLES / (channels > 2 ? channels : 2);
+  chunk_frames = chunk_frames > max_frames ? max_frames : chunk_frames;
+  while (count > 0) {
+    chunk = count > chunk_frames ? chunk_frames : count;
+    if (format == ma_format_f32) {
+      in = (const float*)frames;
+    } else if (format == ma_format_s16) {
+      convertFromS16(converted, (const ma_int16*)frames, chunk * channels);
+      in = converted;
+    } else {
+      ma_pcm_convert(converted, ma_format_f32, frames, format, chunk * channels,
+                     ma_dither_mode_none);
+      in = converted;
+    }
+
+    if (channels != 2) {
+      for (i = 0; i < chunk; i++) {
+        stereo[i * 2] = in[i * channels];
+        stereo[i * 2 + 1] = in[i * channels + (channels > 1 ? 1 : 0)];
+      }
+      in = stereo;
+    }
+    writeCapturedFrames(setup, in, chunk);
+
+    frames = (const char*)frames + chunk * ma_get_bytes_per_frame(format, channels);
+    count -= chunk;
+  }
+}
+
+// zero copy push, get up to two spans of the audio buffer to write count 2 channel f32 frames into
+// directly then call jum_commitSamples. only available while the buffer format is f32
+ma_int32 jum_reserveSamples(jum_AudioSetup* setup, ma_uint32 count, float** first,
+                            ma_uint32* first_frames, float** second, ma_uint32* second_frames) {
+  ma_int32 writer_pos;
+  ma_uint32 remaining;
+
+  if (setup->mode != AUDIO_MODE_PUSH || setup->buffer.format != ma_format_f32) {
+    return -2;
+  }
+  if (count * 2 > (ma_uint32)setup->buffer.sz) {
+    return -1;
+  }
+
+  writer_pos = setup->control.writer_pos;
+  remaining = (setup->buffer.sz - writer_pos) / 2;
+  *first = &setup->buffer.buf[writer_pos];
+  *first_frames = remaining > count ? count : remaining;
+  *second = setup->buffer.buf;
+  *second_frames = count - *first_frames;
+  return 0;
+}
+
+// publish frames written into spans from jum_reserveSamples, same checks as the reserve
+ma_int32 jum_commitSamples(jum_AudioSetup* setup, ma_uint32 count) {
+  ma_int32 reader_pos, writer_pos;
+  ma_uint32 remaining, first;
+
+  if (setup->mode != AUDIO_MODE_PUSH || setup->buffer.format != ma_format_f32) {
+    return -2;
+  }
+  if (count * 2 > (ma_uint32)setup->buffer.sz) {
+    return -1;
+  }
+
+  reader_pos = setup->control.writer_pos;
+  remaining = (setup->buffer.sz - reader_pos) / 2;
+  first = remaining > count ? count : remaining;
+  updateMeter(&setup->meter, &setup->buffer.buf[reader_pos], first, 2);
+  updateMeter(&setup->meter, setup->buffer.buf, count - first, 2);
+  recordFrames(&setup->recorder, &setup->buffer.buf[reader_pos], first);
+  recordFrames(&setup->recorder, setup->buffer.buf, count - first);
+
+  writer_pos = reader_pos + count * 2;
+  if (writer_pos >= setup->buffer.sz) {
+    writer_pos -= setup->buffer.sz;
+  }
+  if (setup->push_next_frame >= 0) {
+    setup->push_next_frame += count;
+  }
+  publishWriterPos(setup, reader_pos, writer_pos);
+  return 0;
+}
+
+void jum_printAudioInfo(AudioInfo info) {
+  switch (info.format) {
+    case (ma_format_u8):
+      printf("ma_format_u8\n");
+      break;
+    case (ma_format_s16):
+      printf("ma_format_s16\n");
+      break;
+    case (ma_format_s24):
+      printf("ma_format_s24\n");
+      break;
+    case (ma_format_s32):
+      printf("ma_format_s32\n");
+      break;
+    case (ma_format_f32):
+      printf("ma_format_f32\n");
+      break;
+    default:
+      printf("unknown\n");
+      break;
+  }
+  printf("num channels %d\n", info.channels);
+  printf("sample rate %d\n", info.sample_rate);
+  printf("bytes per frame %d\n", info.bytes_per_frame);
+}
+
+// start of the next analysis window in the audio buffer. pos and last_publish are the caller's own
+// tracking state, so any number of analyzers can follow one audio setup
+ma_int32 jum_windowPosition(const jum_AudioSetup* audio, ma_int32* pos, ma_uint32* last_publish,
+                            ma_uint32 msec, ma_int32 window_sz, float delay_ms) {
+  ma_uint64 published;
+  ma_int32 reader_pos;
+  ma_int32 temp_pos;
+
+  // increment pointer position (in 32 bit float samples) based on given time
+  *pos += ((audio->info.sample_rate * msec) / 1000L) * audio->info.channels;
+  if (*pos >= audio->buffer.sz) {
+    *pos -= audio->buffer.sz;
+  }
+
+  // read necessary data from the datacallback thread, each analyzer tracks what it has seen itself
+  published = __atomic_load_n(&audio->control.published, __ATOMIC_ACQUIRE);
+  if ((ma_uint32)(published >> 32) != *last_publish) {  // data written to audio stream
+    reader_pos = (ma_int32)(ma_uint32)published;
+    *last_publish = (ma_uint32)(published >> 32);
+  } else {
+    reader_pos = -1;  // no new reader pos
+  }
+
+  // if there was a new reader position
+  if (reader_pos >= 0) {
+    // if the fft position is lagging behind or too far ahead of reader, resync
+    if (*pos < reader_pos || (*pos - reader_pos) > MAX_DESYNC) {
+      *pos = reader_pos;
+    }
+  }
+
+  // temp position since fft_pos keeps up with actual playback rate
+  // if we are capturing, then delay one buffer size behind reader
+  if (audio->mode == AUDIO_MODE_CAPTURE || audio->mode == AUDIO_MODE_DUPLEX ||
+      audio->mode == AUDIO_MODE_PUSH) {
+    temp_pos = *pos - window_sz * audio->info.channels;
   } else {
-    for (ma_uint32 i = 0; i < setup->capture_device_count; i++) {
-      if (setup->capture_device_info[i].isDefault) {
-        selected_device_name = setup->capture_device_info[i].name;
+    temp_pos = *pos;
+  }
+  temp_pos -= (ma_int32)(delay_ms * audio->info.sample_rate / 1000) * audio->info.channels;
+
+  while (temp_pos < 0) {
+    temp_pos = audio->buffer.sz + temp_pos;
+  }
+  return temp_pos;
+}
+
+// perform fft calculation, result is written to fft->result
+void jum_analyze(jum_FFTSetup* fft, jum_AudioSetup* audio, ma_uint32 msec) {
+  TRACE_SCOPE(__func__);
+  ma_int32 temp_pos;
+  struct timespec stage_start;
+  float stage_ms[QUALITY_STAGES];
+  jum_FFTLayout* layout;
+  ma_int32 spread;
+  float distance;
+
+  // tables swapped in between frames so one frame never mixes old and new bins
+  adoptPendingPlan(fft);
+
+  temp_pos = jum_windowPosition(audio, &fft->pos, &fft->last_publish, msec, fft->pffft.sz,
+                                fft->delay_ms);
+
+  if (windowIsSilent(&fft->gate, &audio->buffer, temp_pos,
+                     fft->pffft.sz * audio->info.channels)) {
+    if (!fft->gate.gated) {
+      // onset detection should see the floor, not the last sound, when audio resumes
+      for (ma_int32 i = 0; i < fft->num_bins; i++) {
+        fft->onset_state.prev[i] = SILENT_LEVEL * fft->luts.weights[i];
       }
     }
+    fft->gate.gated = true;
+    fft->level = 0.9F * fft->level;
+    fft->onset = 0;
+    trackTempo(fft, 0, msec);
+    if (fft->gate.settled) {
+      return;
+    }
+    // same decay applyAveraging would give for a silent frame, without transforming silence
+    distance = decayToFloor(fft->averaged, fft->luts.weights, fft->num_bins);
+    applySmoothing(fft->averaged, fft->result, fft->num_bins, SMOOTHING_SPREAD);
+    fft->max = normalizeArray(fft->result, fft->num_bins, fft->max, &fft->output);
+    recordHistory(&fft->history, fft->result, fft->num_bins);
+    for (layout = fft->layouts; layout != NULL; layout = layout->next) {
+      distance = fmaxf(distance, decayLayout(layout));
+    }
+    if (distance < 1e-4F) {
+      fft->gate.settled = true;
+    }
+    return;
+  }
+  fft->gate.gated = false;
+  fft->gate.settled = false;
+
+  if (fft->quality.level >= JUM_QUALITY_SKIP_FRAMES) {
+    fft->quality.skip_next = !fft->quality.skip_next;
+    if (!fft->quality.skip_next) {
+      fft->quality.skipped_ms += msec;
+      return;
+    }
+  }
+  msec += fft->quality.skipped_ms;
+  fft->quality.skipped_ms = 0;
+  clock_gettime(CLOCK_MONOTONIC, &stage_start);
+
+  if (audio->buffer.format == ma_format_s16) {
+    readIntoFFTBufferS16(audio->buffer.buf_s16, temp_pos, audio->buffer.sz, fft->pffft.in,
+                         fft->pffft.sz, fft->luts.hamming, audio->info.channels);
+  } else {
+    readIntoFFTBuffer(audio->buffer.buf, temp_pos, audio->buffer.sz, fft->pffft.in, fft->pffft.sz,
+                      fft->luts.hamming, audio->info.channels);
+  }
+  fft->level = averageLevel(fft->pffft.in, fft->pffft.sz, fft->level);
+  {
+    TRACE_SCOPE(fft->pffft.backend->name);
+    fft->pffft.backend->transform(fft->pffft.setup, fft->pffft.in, fft->pffft.out,
+                                  fft->pffft.work);
   }
+  stage_ms[0] = elapsedMs(&stage_start);
+
+  readMagnitudes(fft->magnitudes, fft->pffft.out, fft->pffft.sz);
+  readIntoBins(fft->raw, fft->luts.freqs, fft->num_bins, fft->magnitudes, fft->pffft.sz,
+               audio->info.sample_rate);
+  if (fft->pffft.sz != fft->plan->fft_sz) {
+    // magnitudes scale with transform size, keep reduced quality levels at the same height
+    for (ma_int32 i = 0; i < fft->num_bins; i++) {
+      fft->raw[i] *= (float)fft->plan->fft_sz / fft->pffft.sz;
+    }
+  }
+  applyWeighting(fft->raw, fft->luts.weights, fft->num_bins);
+  detectOnsets(fft, msec);
+  applyAveraging(fft->raw, fft->averaged, fft->num_bins);
+  stage_ms[1] = elapsedMs(&stage_start);
+
+  spread = fft->quality.level >= JUM_QUALITY_REDUCED_SMOOTHING ? 1 : SMOOTHING_SPREAD;
+  applySmoothing(fft->averaged, fft->result, fft->num_bins, spread);
+  fft->max = normalizeArray(fft->result, fft->num_bins, fft->max, &fft->output);
+  recordHistory(&fft->history, fft->result, fft->num_bins);
+  for (layout = fft->layouts; layout != NULL; layout = layout->next) {
+    updateLayout(layout, fft, audio->info.sample_rate, spread);
+  }
+  stage_ms[2] = elapsedMs(&stage_start);
+
+  adaptQuality(fft, stage_ms);
+}
+
+// ms since the given time, which is then reset to now
+float elapsedMs(struct timespec* since) {
+  struct timespec now;
+  float ms;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ms = (now.tv_sec - since->tv_sec) * 1000.0F + (now.tv_nsec - since->tv_nsec) / 1000000.0F;
+  *since = now;
+  return ms;
+}
+
+// track stage costs and step the quality level down when consistently over budget, back up when
+// there is plenty of headroom
+void adaptQuality(jum_FFTSetup* fft, const float* stage_ms) {
+  QualityControl* quality = &fft->quality;
+  float total = 0;
+  ma_int32 i;
+
+  for (i = 0; i < QUALITY_STAGES; i++) {
+    quality->stage_ms[i] = 0.8F * quality->stage_ms[i] + 0.2F * stage_ms[i];
+    total += stage_ms[i];
+  }
+  quality->total_ms = 0.8F * quality->total_ms + 0.2F * total;
+
+  if (quality->budget_ms <= 0) {
+    return;
+  }
+
+  quality->over_count = total > quality->budget_ms ? quality->over_count + 1 : 0;
+  quality->under_count = total < quality->budget_ms / 2 ? quality->under_count + 1 : 0;
+
+  if (quality->over_count >= QUALITY_DEGRADE_FRAMES && quality->level < JUM_QUALITY_SKIP_FRAMES) {
+    applyQualityLevel(fft, quality->level + 1);
+  } else if (quality->under_count >= QUALITY_RECOVER_FRAMES && quality->level > JUM_QUALITY_FULL) {
+    applyQualityLevel(fft, quality->level - 1);
+  }
+}
+
+// switch which plan is used for the transform, levels whose plan isn't available are skipped
+void applyQualityLevel(jum_FFTSetup* fft, jum_Quality level) {
+  QualityControl* quality = &fft->quality;
+  FFTPlan* plan;
+
+  if (level == JUM_QUALITY_QUARTER_FFT && quality->reduced_plans[1] == NULL) {
+    level = level > quality->level ? JUM_QUALITY_SKIP_FRAMES : JUM_QUALITY_HALF_FFT;
+  }
+  if (level == JUM_QUALITY_HALF_FFT && quality->reduced_plans[0] == NULL) {
+    level = level > quality->level ? JUM_QUALITY_SKIP_FRAMES : JUM_QUALITY_REDUCED_SMOOTHING;
+  }
+
+  if (level >= JUM_QUALITY_QUARTER_FFT && quality->reduced_plans[1] != NULL) {
+    plan = quality->reduced_plans[1];
+  } else if (level >= JUM_QUALITY_HALF_FFT && quality->reduced_plans[0] != NULL) {
+    plan = quality->reduced_plans[0];
+  } else {
+    plan = fft->plan;
+  }
+  fft->pffft.setup = plan->setup;
+  fft->pffft.backend = plan->backend;
+  fft->pffft.sz = plan->fft_sz;
+  fft->luts.hamming = plan->luts.hamming;
+
+  quality->level = level;
+  quality->over_count = 0;
+  quality->under_count = 0;
+  quality->skip_next = false;
+}
+
+// apply windowing and copy to fft buffer
+void readIntoFFTBuffer(const float* samples_in, ma_int32 in_pos, ma_int32 in_size,
+                       float* samples_out, ma_int32 out_size, const float* hamming,
+                       ma_int32 channels) {
+  TRACE_SCOPE(__func__);
+  ma_int32 i;
+  for (i = 0; i < out_size; i++) {
+    samples_out[i] = samples_in[in_pos % in_size] * hamming[i];
+    in_pos++;
+    if (channels == 2) {  // two channels, use average
+      samples_out[i] += samples_in[in_pos % in_size] * hamming[i];
+      samples_out[i] /= 2;
+      in_pos++;
+    }
+  }
+}
+
+// same as readIntoFFTBuffer but from s16 storage, conversion scale and channel average are folded
+// into a single multiply, reads contiguous runs up to the wrap point instead of taking modulo
+void readIntoFFTBufferS16(const ma_int16* samples_in, ma_int32 in_pos, ma_int32 in_size,
+                          float* samples_out, ma_int32 out_size, const float* hamming,
+                          ma_int32 channels) {
+  TRACE_SCOPE(__func__);
+  const float scale = 1.0F / (32767.0F * channels);
+  ma_int32 i = 0;
+  ma_int32 end;
+#if defined(__SSE2__)
+  __m128 vscale = _mm_set1_ps(scale);
+  __m128i ones = _mm_set1_epi16(1);
+  __m128i sum;
+#elif defined(__ARM_NEON)
+  float32x4_t vscale = vdupq_n_f32(scale);
+  int32x4_t sum;
+#endif
+
+  in_pos %= in_size;
+  while (i < out_size) {
+    // frames until the buffer wraps
+    end = i + (in_size - in_pos) / channels;
+    if (end > out_size)
+      end = out_size;
+    if (channels == 2) {
+#if defined(__SSE2__)
+      for (; i + 4 <= end; i += 4) {
+        // multiply add against 1 sums each left/right pair into 32 bits
+        sum = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)&samples_in[in_pos]), ones);
+        _mm_storeu_ps(&samples_out[i], _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), vscale),
+                                                  _mm_loadu_ps(&hamming[i])));
+        in_pos += 8;
+      }
+#elif defined(__ARM_NEON)
+      for (; i + 4 <= end; i += 4) {
+        sum = vpaddlq_s16(vld1q_s16(&samples_in[in_pos]));
+        vst1q_f32(&samples_out[i],
+                  vmulq_f32(vmulq_f32(vcvtq_f32_s32(sum), vscale), vld1q_f32(&hamming[i])));
+        in_pos += 8;
+      }
+#endif
+      for (; i < end; i++) {
+        samples_out[i] = (samples_in[in_pos] + samples_in[in_pos + 1]) * scale * hamming[i];
+        in_pos += 2;
+      }
+    } else {
+      for (; i < end; i++) {
+        samples_out[i] = samples_in[in_pos] * scale * hamming[i];
+        in_pos++;
+      }
+    }
+    if (in_pos + channels > in_size)
+      in_pos = 0;
+  }
+}
+
+float averageLevel(const float* samples, ma_int32 sz, float prev_level) {
+  ma_int32 i;
+  float level = 0;
+  for (i = 0; i < sz; i++) {
+    level += samples[i] * samples[i];
+  }
+  level /= sz;
+  level = sqrtf(level) * 5;
+
+  if (level > prev_level)
+    level = (0.5F) * prev_level + ((1 - 0.5F) * level);
+  else
+    level = (0.9F) * prev_level + ((1 - 0.9F) * level);
+
+  return level;
+}
+
+// set up K-weighting filters (ITU-R BS.1770) and true peak interpolator for the sample rate,
+// coefficient formulas are the same as used by libebur128 so any rate is supported
+// the previous device or push producer may still be updating the meter, so the reset is handed to
+// whichever producer runs next and applied there before its next update
+void resetMeter(Meter* meter, ma_uint32 sample_rate) {
+  __atomic_store_n(&meter->pending_rate, sample_rate, __ATOMIC_RELEASE);
+}
+
+// only called by the producer, seq is odd while the snapshot is cleared
+void initMeter(Meter* meter, ma_uint32 sample_rate) {
+  double f0, gain_db, q, k, vh, vb, a0, x, window;
+  ma_int32 n, len;
+  ma_uint32 seq;
+
+  seq = meter->seq;
+  __atomic_store_n(&meter->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memset(meter, 0, offsetof(Meter, seq));
+  memset(&meter->snapshot, 0, sizeof(jum_MeterSnapshot));
+
+  // stage 1: high shelf
+  f0 = 1681.974450955533;
+  gain_db = 3.999843853973347;
+  q = 0.7071752369554196;
+  k = tan(M_PI * f0 / sample_rate);
+  vh = pow(10.0, gain_db / 20.0);
+  vb = pow(vh, 0.4996667741545416);
+  a0 = 1.0 + k / q + k * k;
+  meter->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+  meter->shelf.b1 = 2.0 * (k * k - vh) / a0;
+  meter->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+  meter->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+  meter->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+  // stage 2: high pass
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan(M_PI * f0 / sample_rate);
+  a0 = 1.0 + k / q + k * k;
+  meter->highpass.b0 = 1.0;
+  meter->highpass.b1 = -2.0;
+  meter->highpass.b2 = 1.0;
+  meter->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+  meter->highpass.a2 = (1.0 - k / q + k * k) / a0;
+
+  // windowed sinc interpolator split into polyphase branches, each branch sums to ~1
+  len = TRUE_PEAK_OVERSAMPLE * TRUE_PEAK_TAPS;
+  for (n = 0; n < len; n++) {
+    x = (n - (len - 1) / 2.0) / TRUE_PEAK_OVERSAMPLE;
+    window = 0.5 * (1 - cos(2 * M_PI * (n + 0.5) / len));
+    meter->tp_coeffs[n % TRUE_PEAK_OVERSAMPLE][n / TRUE_PEAK_OVERSAMPLE] =
+        (x == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x)) * window;
+  }
+
+  meter->rms_coeff = 1.0 - exp(-1.0 / (0.3 * sample_rate));
+  meter->release = exp(-1.0 / (1.5 * sample_rate));
+  meter->block_len = sample_rate * METER_BLOCK_MS / 1000;
+  meter->snapshot.momentary = -70;
+  meter->snapshot.short_term = -70;
+  __atomic_store_n(&meter->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+float processBiquad(const Biquad* filter, float* state, float x) {
+  // transposed direct form II
+  float y = filter->b0 * x + state[0];
+  state[0] = filter->b1 * x - filter->a1 * y + state[1];
+  state[1] = filter->b2 * x - filter->a2 * y;
+  return y;
+}
+
+// called from the audio callback with the new frames only, O(frame_count)
+void updateMeter(Meter* meter, const float* frames, ma_uint32 frame_count, ma_uint32 channels) {
+  ma_uint32 i, c, p, t, rate;
+  float x, y, a, interp;
+  float* history;
+
+  rate = __atomic_exchange_n(&meter->pending_rate, 0, __ATOMIC_ACQUIRE);
+  if (rate != 0) {
+    initMeter(meter, rate);
+  }
+  if (meter->block_len == 0 || channels > METER_CHANNELS) {
+    return;
+  }
+
+  for (i = 0; i < frame_count; i++) {
+    for (c = 0; c < channels; c++) {
+      x = frames[i * channels + c];
+
+      meter->mean_square[c] += meter->rms_coeff * (x * x - meter->mean_square[c]);
+
+      a = fabsf(x);
+      meter->peak[c] *= meter->release;
+      if (a > meter->peak[c])
+        meter->peak[c] = a;
+
+      // oversample by evaluating each polyphase branch over the recent input
+      history = meter->tp_history[c];
+      memmove(&history[1], &history[0], (TRUE_PEAK_TAPS - 1) * sizeof(float));
+      history[0] = x;
+      meter->true_peak[c] *= meter->release;
+      for (p = 0; p < TRUE_PEAK_OVERSAMPLE; p++) {
+        interp = 0;
+        for (t = 0; t < TRUE_PEAK_TAPS; t++) {
+          interp += meter->tp_coeffs[p][t] * history[t];
+        }
+        interp = fabsf(interp);
+        if (interp > meter->true_peak[c])
+          meter->true_peak[c] = interp;
+      }
+
+      y = processBiquad(&meter->shelf, meter->shelf_state[c], x);
+      y = processBiquad(&meter->highpass, meter->highpass_state[c], y);
+      meter->block_energy += y * y;
+    }
+
+    meter->block_pos++;
+    if (meter->block_pos >= meter->block_len) {
+      meter->blocks[meter->block_index] = meter->block_energy / meter->block_len;
+      meter->block_index = (meter->block_index + 1) % METER_SHORT_TERM_BLOCKS;
+      meter->block_energy = 0;
+      meter->block_pos = 0;
+    }
+  }
+
+  publishMeter(meter);
+}
+
+// loudness over the most recent num_blocks completed blocks, floored at the -70 LUFS gate
+float meterLoudness(const Meter* meter, ma_uint32 num_blocks) {
+  ma_uint32 i, index;
+  float energy = 0;
+  for (i = 0; i < num_blocks; i++) {
+    index = (meter->block_index + METER_SHORT_TERM_BLOCKS - 1 - i) % METER_SHORT_TERM_BLOCKS;
+    energy += meter->blocks[index];
+  }
+  energy /= num_blocks;
+  if (energy <= 0) {
+    return -70;
+  }
+  energy = -0.691F + 10 * log10f(energy);
+  return energy < -70 ? -70 : energy;
+}
+
+// write snapshot between two increments of seq, readers retry if seq was odd or changed
+void publishMeter(Meter* meter) {
+  ma_uint32 seq;
+  ma_uint32 c;
+
+  seq = meter->seq;
+  __atomic_store_n(&meter->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (c = 0; c < METER_CHANNELS; c++) {
+    meter->snapshot.rms[c] = sqrtf(meter->mean_square[c]);
+    meter->snapshot.peak[c] = meter->peak[c];
+    meter->snapshot.true_peak[c] = meter->true_peak[c];
+  }
+  meter->snapshot.momentary = meterLoudness(meter, METER_MOMENTARY_BLOCKS);
+  meter->snapshot.short_term = meterLoudness(meter, METER_SHORT_TERM_BLOCKS);
+  __atomic_store_n(&meter->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// copy out latest meter values, never blocks the audio callback
+void jum_getMeter(jum_AudioSetup* setup, jum_MeterSnapshot* snapshot) {
+  ma_uint32 seq;
+  do {
+    seq = __atomic_load_n(&setup->meter.seq, __ATOMIC_ACQUIRE);
+    *snapshot = setup->meter.snapshot;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || seq != __atomic_load_n(&setup->meter.seq, __ATOMIC_RELAXED));
+}
+
+// take equally distributed fft samples and average into bins
+// magnitude of each complex pair in the ordered fft output, computed once per transform
+void readMagnitudes(float* magnitudes, const float* fft, ma_int32 fft_sz) {
+  TRACE_SCOPE(__func__);
+  ma_int32 i = 0;
+#if defined(__SSE2__)
+  __m128 a, b, re, im;
+  for (; i + 4 <= fft_sz / 2; i += 4) {
+    a = _mm_loadu_ps(&fft[i * 2]);
+    b = _mm_loadu_ps(&fft[i * 2 + 4]);
+    re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(&magnitudes[i], _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+  }
+#endif
+  for (; i < fft_sz / 2; i++) {
+    magnitudes[i] = sqrtf((fft[i * 2] * fft[i * 2]) + (fft[i * 2 + 1] * fft[i * 2 + 1]));
+  }
+}
+
+void readIntoBins(float* out, const float* freqs, ma_int32 out_sz, const float* magnitudes,
+                  ma_int32 fft_sz, float sample_rate) {
+  TRACE_SCOPE(__func__);
+  float freq;
+  ma_int32 current_bin = 0;
+  ma_int32 samples_in_bin = 0;
+  ma_int32 i;
+  out[0] = 0;
+
+  // read from raw output into bins and average
+  for (i = 0; i < fft_sz / 2; i++) {
+    // frequency for this sample
+    freq = (i * (sample_rate / 2)) / (fft_sz / 2);
+    // fits into current bin
+    if (freq > freqs[current_bin]) {       // passed current bin
+      out[current_bin] /= samples_in_bin;  // take average
+      samples_in_bin = 0;
+      current_bin++;
+
+      while (freq > freqs[current_bin]) {
+        if (current_bin >= out_sz)
+          break;
+        // if skipping multiple bins then duplicate prev value TODO could smooth better?
+        if (current_bin != 0)
+          out[current_bin] = out[current_bin - 1];
+        current_bin++;
+      }
+      if (current_bin >= out_sz)
+        break;
+
+      out[current_bin] = 0;  // set to 0 so that we can +=
+    }
+
+    out[current_bin] += magnitudes[i];
+    samples_in_bin++;
+  }
+}
+
+void applyWeighting(float* data, const float* weights, ma_int32 size) {
+  ma_int32 i;
+  for (i = 0; i < size; i++) {
+    // log scaling
+    data[i] = log10f(data[i] + 0.5) + 0.31;  // prevent negative numbers, see SILENT_LEVEL
+    // apply weighting
+    data[i] *= weights[i];
+  }
+}
+
+// scan only the samples that entered the window since last call, window is silent once a full
+// window length has passed with nothing above threshold
+bool windowIsSilent(SilenceGate* gate, const AudioBuffer* buffer, ma_int32 window_pos,
+                    ma_int32 window_sz) {
+  ma_int32 end, new_samples, pos, i;
+  float threshold;
+  bool loud = false;
+
+  end = (window_pos + window_sz) % buffer->sz;
+  new_samples = gate->last_end < 0 ? window_sz : end - gate->last_end;
+  if (new_samples < 0)
+    new_samples += buffer->sz;
+  if (new_samples > window_sz)
+    new_samples = window_sz;
+  gate->last_end = end;
+
+  pos = end - new_samples;
+  if (pos < 0)
+    pos += buffer->sz;
+  if (buffer->format == ma_format_s16) {
+    threshold = gate->threshold * 32767.0F;
+    for (i = 0; i < new_samples && !loud; i++) {
+      loud = abs(buffer->buf_s16[pos]) > threshold;
+      pos = pos + 1 < buffer->sz ? pos + 1 : 0;
+    }
+  } else {
+    for (i = 0; i < new_samples && !loud; i++) {
+      loud = fabsf(buffer->buf[pos]) > gate->threshold;
+      pos = pos + 1 < buffer->sz ? pos + 1 : 0;
+    }
+  }
+
+  gate->quiet_run = loud ? 0 : gate->quiet_run + new_samples;
+  return gate->quiet_run >= window_sz;
+}
+
+// applyAveraging step for a silent frame, where every bin of the weighted spectrum is the floor.
+// same asymmetric rule, bins below the floor jump up to it. returns largest remaining distance
+float decayToFloor(float* averaged, const float* weights, ma_int32 size) {
+  ma_int32 i;
+  float floor, distance, max_distance = 0;
+  for (i = 0; i < size; i++) {
+    floor = SILENT_LEVEL * weights[i];
+    if (floor > averaged[i]) {
+      averaged[i] = (0.2F) * averaged[i] + ((1 - 0.2F) * floor);
+    } else {
+      averaged[i] = (0.9F) * averaged[i] + ((1 - 0.9F) * floor);
+    }
+    distance = fabsf(averaged[i] - floor);
+    if (distance > max_distance)
+      max_distance = distance;
+  }
+  return max_distance;
+}
+
+void applyAveraging(const float* current, float* averaged, ma_int32 size) {
+  ma_int32 i;
+  for (i = 0; i < size; i++) {
+    // apply exponential moving average
+    if (current[i] > averaged[i]) {
+      // jump up quickly
+      averaged[i] = (0.2F) * averaged[i] + ((1 - 0.2F) * current[i]);
+    } else {
+      // fall down slowly
+      averaged[i] = (0.9F) * averaged[i] + ((1 - 0.9F) * current[i]);
+    }
+  }
+}
+
+// spread is how many extra bins either side low frequencies are smoothed over compared to high
+void applySmoothing(const float* in, float* out, ma_int32 size, ma_int32 spread) {
+  TRACE_SCOPE(__func__);
+  ma_int32 i, j, sample_width;
+  float x;
+  for (i = 0; i < size; i++) {
+    // smooth between frequency bins
+    // number of surrounding bins in each direction to take avg of
+    x = ((float)size - (float)i) / ((float)size);
+    sample_width = (ma_int32)(x * spread) + 2;
+    for (j = 0; j < sample_width; j++) {
+      if (i - j > 0)
+        out[i] += in[i - j] / (sample_width * 2);
+      if (i + j < size)
+        out[i] += in[i + j] / (sample_width * 2);
+    }
+  }
+}
+
+void initOnsetTracker(OnsetTracker* tracker) {
+  ma_int32 i;
+  float bpm, octaves;
+  for (i = 0; i < TEMPO_LAGS; i++) {
+    // log gaussian centred on 120 bpm, one octave either side is still weighted ~0.5
+    bpm = 60.0F * ONSET_ENV_RATE / (TEMPO_MIN_LAG + i);
+    octaves = log2f(bpm / 120.0F);
+    tracker->prior[i] = expf(-0.5F * octaves * octaves / (0.85F * 0.85F));
+  }
+}
+
+// half wave rectified spectral flux per band of the weighted spectrum against an adaptive
+// threshold, O(num_bins)
+void detectOnsets(jum_FFTSetup* fft, ma_uint32 msec) {
+  OnsetTracker* tracker = &fft->onset_state;
+  ma_int32 band, i, start, end;
+  float diff, flux, total, alpha, deviation;
+
+  fft->onset = 0;
+  total = 0;
+  alpha = 1 - expf(-(float)msec / ONSET_STATS_MS);
+  tracker->since_onset += msec;
+
+  for (band = 0; band < ONSET_BANDS; band++) {
+    start = (fft->num_bins * band) / ONSET_BANDS;
+    end = (fft->num_bins * (band + 1)) / ONSET_BANDS;
+    flux = 0;
+    for (i = start; i < end; i++) {
+      diff = fft->raw[i] - tracker->prev[i];
+      if (diff > 0)
+        flux += diff;
+      tracker->prev[i] = fft->raw[i];
+    }
+    flux /= (end - start);
+    fft->flux[band] = flux;
+    total += flux;
+
+    if (tracker->since_onset >= ONSET_MIN_INTERVAL &&
+        flux > tracker->mean[band] + ONSET_THRESHOLD * sqrtf(tracker->var[band])) {
+      fft->onset |= 1u << band;
+    }
+
+    deviation = flux - tracker->mean[band];
+    tracker->mean[band] += alpha * deviation;
+    tracker->var[band] = (1 - alpha) * (tracker->var[band] + alpha * deviation * deviation);
+  }
+
+  if (fft->onset) {
+    tracker->since_onset = 0;
+  }
+
+  // onset strength is total flux above its running mean
+  deviation = total - tracker->mean_total;
+  tracker->mean_total += alpha * deviation;
+  trackTempo(fft, deviation > 0 ? deviation : 0, msec);
+}
+
+// resample onset strength to a fixed rate, keep a leaky autocorrelation over tempo lags updated
+// one env sample at a time, and run the beat phase forward, nudging it towards detected onsets
+void trackTempo(jum_FFTSetup* fft, float strength, ma_uint32 msec) {
+  OnsetTracker* tracker = &fft->onset_state;
+  ma_int32 lag, best, prev_pos;
+  float decay, score, best_score, period, error;
+  float prev_score, next_score, denom, lag_offset;
+
+  if (strength > tracker->env_peak)
+    tracker->env_peak = strength;
+
+  decay = expf(-1000.0F / (ONSET_ENV_RATE * TEMPO_MEMORY_MS));
+  tracker->env_time += msec;
+  while (tracker->env_time >= 1000.0F / ONSET_ENV_RATE) {
+    tracker->env_time -= 1000.0F / ONSET_ENV_RATE;
+    tracker->env[tracker->env_pos] = tracker->env_peak;
+    for (lag = TEMPO_MIN_LAG; lag <= TEMPO_MAX_LAG; lag++) {
+      prev_pos = (tracker->env_pos - lag + ONSET_ENV_SIZE) % ONSET_ENV_SIZE;
+      tracker->acf[lag - TEMPO_MIN_LAG] = decay * tracker->acf[lag - TEMPO_MIN_LAG] +
+                                          tracker->env_peak * tracker->env[prev_pos];
+    }
+    tracker->env_pos = (tracker->env_pos + 1) % ONSET_ENV_SIZE;
+    tracker->env_peak = 0;
+  }
+
+  best = -1;
+  best_score = 0;
+  for (lag = 0; lag < TEMPO_LAGS; lag++) {
+    score = tracker->acf[lag] * tracker->prior[lag];
+    if (score > best_score) {
+      best_score = score;
+      best = lag;
+    }
+  }
+  if (best < 0) {
+    fft->bpm = 0;
+  } else {
+    // parabolic interpolation between neighbouring lags for sub-lag tempo resolution
+    lag_offset = 0;
+    if (best > 0 && best < TEMPO_LAGS - 1) {
+      prev_score = tracker->acf[best - 1] * tracker->prior[best - 1];
+      next_score = tracker->acf[best + 1] * tracker->prior[best + 1];
+      denom = prev_score - 2 * best_score + next_score;
+      if (denom < 0)
+        lag_offset = 0.5F * (prev_score - next_score) / denom;
+    }
+    fft->bpm = 60.0F * ONSET_ENV_RATE / (TEMPO_MIN_LAG + best + lag_offset);
+  }
+
+  fft->beat = false;
+  if (fft->bpm <= 0) {
+    return;
+  }
+  period = 60000.0F / fft->bpm;
+  fft->beat_phase += msec / period;
+  if (fft->beat_phase >= 1) {
+    fft->beat_phase -= floorf(fft->beat_phase);
+    fft->beat = true;
+  }
+  if (fft->onset) {
+    // pull phase towards 0 when an onset lands near a predicted beat
+    error = fft->beat_phase < 0.5F ? fft->beat_phase : fft->beat_phase - 1;
+    fft->beat_phase -= 0.2F * error;
+    if (fft->beat_phase < 0)
+      fft->beat_phase += 1;
+  }
+}
+
+// normalizes in place, and if a target is given writes the converted values to it in the same pass
+// so the caller doesn't need its own conversion pass over result
+float normalizeArray(float* array, ma_int32 size, float max, const OutputTarget* target) {
+  ma_int32 i;
+  char* dst;
+  // first pass check if max provided has been exceeded
+  for (i = 0; i < size; i++) {
+    if (array[i] > max)
+      max = array[i];
+  }
+  if (target == NULL || target->dst == NULL) {
+    // second pass, normalize result based on max, min is always 0
+    for (i = 0; i < size; i++) {
+      array[i] = (array[i] - 0) / (max - 0);
+    }
+    return max;
+  }
+
+  // second pass, normalize and write out to target
+  dst = (char*)target->dst;
+  for (i = 0; i < size; i++) {
+    array[i] = (array[i] - 0) / (max - 0);
+    storeOutput(dst, target->type, array[i] * target->scale + target->offset);
+    dst += target->stride;
+  }
+  return max;
+}
+
+void storeOutput(void* dst, jum_OutputType type, float x) {
+  switch (type) {
+    case JUM_OUTPUT_F32:
+      *(float*)dst = x;
+      break;
+    case JUM_OUTPUT_F16:
+      *(ma_uint16*)dst = floatToHalf(x);
+      break;
+    case JUM_OUTPUT_U16:
+      x = x < 0 ? 0 : (x > 65535.0F ? 65535.0F : x);
+      *(ma_uint16*)dst = (ma_uint16)(x + 0.5F);
+      break;
+    case JUM_OUTPUT_U8:
+      x = x < 0 ? 0 : (x > 255.0F ? 255.0F : x);
+      *(ma_uint8*)dst = (ma_uint8)(x + 0.5F);
+      break;
+  }
+}
+
+size_t outputTypeSize(jum_OutputType type) {
+  switch (type) {
+    case JUM_OUTPUT_F16:
+    case JUM_OUTPUT_U16:
+      return 2;
+    case JUM_OUTPUT_U8:
+      return 1;
+    default:
+      return 4;
+  }
+}
+
+// round to nearest even, overflow goes to infinity and values below half range flush to zero
+ma_uint16 floatToHalf(float x) {
+  ma_uint32 bits, sign, mantissa;
+  ma_int32 exponent;
+
+  memcpy(&bits, &x, sizeof(bits));
+  sign = (bits >> 16) & 0x8000;
+  exponent = (ma_int32)((bits >> 23) & 0xff) - 127 + 15;
+  mantissa = bits & 0x7fffff;
+
+  if (((bits >> 23) & 0xff) == 0xff) {  // inf or nan
+    return (ma_uint16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+  if (exponent >= 31) {
+    return (ma_uint16)(sign | 0x7c00);
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return (ma_uint16)sign;
+    }
+    // subnormal half, round half to even on the bits shifted out
+    mantissa |= 0x800000;
+    bits = mantissa >> (14 - exponent);
+    if (((mantissa >> (13 - exponent)) & 1) &&
+        ((mantissa & ((1u << (13 - exponent)) - 1)) || (bits & 1)))
+      bits++;
+    return (ma_uint16)(sign | bits);
+  }
+  bits = sign | ((ma_uint32)exponent << 10) | (mantissa >> 13);
+  // round half to even on the dropped mantissa bits, carry may bump exponent which is correct
+  if ((mantissa & 0x1000) && (mantissa & 0x2fff))
+    bits++;
+  return (ma_uint16)bits;
+}
+
+// skip transforming while the analysis window peaks at or below threshold (linear), output keeps
+// decaying as if silence was analyzed. 0 only skips digital silence, negative disables
+void jum_setSilenceThreshold(jum_FFTSetup* setup, float threshold) {
+  setup->gate.threshold = threshold;
+  setup->gate.quiet_run = 0;
+}
+
+// adapt analysis quality so a jum_analyze call stays within budget_ms, 0 disables and restores full
+// quality. plans for the reduced fft sizes are built here so switching never allocates
+void jum_setTimeBudget(jum_FFTSetup* setup, float budget_ms) {
+  QualityControl* quality = &setup->quality;
+  FFTPlan* plan = setup->plan;
+  ma_int32 i;
+
+  quality->budget_ms = budget_ms;
+  if (budget_ms > 0) {
+    for (i = 0; i < 2; i++) {
+      // stays NULL if no backend supports the reduced size
+      if (quality->reduced_plans[i] == NULL) {
+        quality->reduced_plans[i] =
+            acquireFFTPlan((const float(*)[2])plan->freq_points, plan->freqs_sz,
+                           (const float(*)[2])plan->weight_points, plan->weights_sz,
+                           plan->fft_sz >> (i + 1), plan->num_bins);
+      }
+    }
+    return;
+  }
+
+  applyQualityLevel(setup, JUM_QUALITY_FULL);
+  for (i = 0; i < 2; i++) {
+    if (quality->reduced_plans[i] != NULL) {
+      releaseFFTPlan(quality->reduced_plans[i]);
+      quality->reduced_plans[i] = NULL;
+    }
+  }
+}
+
+// keep the last num_rows results (one in every decimation frames) in a circular row-major buffer,
+// integer types are scaled to their full range. call again to resize, 0 rows to disable
+ma_int32 jum_enableHistory(jum_FFTSetup* setup, ma_int32 num_rows, ma_int32 decimation,
+                           jum_OutputType type) {
+  History* history = &setup->history;
+
+  pffft_aligned_free(history->rows);
+  history->rows = NULL;
+  history->num_rows = 0;
+  if (num_rows <= 0) {
+    return 0;
+  }
+
+  // sized for the most bins jum_swapTables allows so rows never need to move
+  history->row_sz = setup->max_bins * outputTypeSize(type);
+  history->rows = pffft_aligned_malloc(num_rows * history->row_sz);
+  if (history->rows == NULL) {
+    return -1;
+  }
+  memset(history->rows, 0, num_rows * history->row_sz);
+  history->num_rows = num_rows;
+  history->head = num_rows - 1;
+  history->filled = 0;
+  history->decimation = decimation < 1 ? 1 : decimation;
+  history->skipped = 0;
+  history->type = type;
+  history->scale = type == JUM_OUTPUT_U8 ? 255.0F : (type == JUM_OUTPUT_U16 ? 65535.0F : 1.0F);
+
+  return 0;
+}
+
+// oldest to newest rows as at most two contiguous spans, for uploading straight to a texture
+// returns the total number of rows filled so far
+ma_int32 jum_getHistory(jum_FFTSetup* setup, const void** first, ma_int32* first_rows,
+                        const void** second, ma_int32* second_rows) {
+  History* history = &setup->history;
+  ma_int32 oldest;
+
+  *first = NULL;
+  *second = NULL;
+  *first_rows = 0;
+  *second_rows = 0;
+  if (history->rows == NULL || history->filled == 0) {
+    return 0;
+  }
+
+  oldest = (history->head + 1) % history->num_rows;
+  if (history->filled < history->num_rows) {
+    oldest = 0;
+  }
+  *first = (const char*)history->rows + oldest * history->row_sz;
+  *first_rows = (oldest <= history->head ? history->head + 1 : history->num_rows) - oldest;
+  if (oldest > history->head) {
+    *second = history->rows;
+    *second_rows = history->head + 1;
+  }
+  return history->filled;
+}
+
+// just the shared plan (backend setup and lookup tables) without a jum_FFTSetup arena, for
+// analyzers that keep their own buffers. NULL if the backend couldn't be created
+FFTPlan* jum_acquireFFTPlan(const float freq_points[][2], ma_int32 freqs_sz,
+                            const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
+                            ma_int32 num_bins) {
+  return acquireFFTPlan(freq_points, freqs_sz, weight_points, weights_sz, fft_sz, num_bins);
+}
+
+void jum_releaseFFTPlan(FFTPlan* plan) {
+  if (plan != NULL) {
+    releaseFFTPlan(plan);
+  }
+}
+
+// analyze delay_ms further behind the newest audio than the default, so analyzers sharing one
+// audio setup can each line up with a different output latency
+void jum_setAnalysisDelay(jum_FFTSetup* setup, float delay_ms) {
+  setup->delay_ms = delay_ms < 0 ? 0 : delay_ms;
+}
+
+// replace the frequency/weight tables and bin count without reinitializing, e.g. from a settings
+// panel. tables are built on the calling thread and swapped in at the start of the next
+// jum_analyze, which never blocks on this. num_bins can't exceed the count given at init
+ma_int32 jum_swapTables(jum_FFTSetup* setup, const float freq_points[][2], ma_int32 freqs_sz,
+                        const float weight_points[][2], ma_int32 weights_sz, ma_int32 num_bins) {
+  FFTPlan* plan;
+
+  if (num_bins <= 0 || num_bins > setup->max_bins) {
+    printf("WARNING: can't swap to %d bins, setup was created with %d\n", num_bins,
+           setup->max_bins);
+    return -2;
+  }
+  // previous swap has been picked up by now or is about to be replaced, either way it's done with
+  plan = __atomic_exchange_n(&setup->retired_plan, NULL, __ATOMIC_ACQ_REL);
+  if (plan != NULL) {
+    releaseFFTPlan(plan);
+  }
+
+  plan = acquireFFTPlan(freq_points, freqs_sz, weight_points, weights_sz, setup->plan->fft_sz,
+                        num_bins);
+  if (plan == NULL) {
+    printf("Failed to create fft plan\n");
+    return -1;
+  }
+  // superseded before jum_analyze got to it
+  plan = __atomic_exchange_n(&setup->pending_plan, plan, __ATOMIC_ACQ_REL);
+  if (plan != NULL) {
+    releaseFFTPlan(plan);
+  }
+  return 0;
+}
+
+// switch to tables from jum_swapTables, resampling averaging state so the output carries on
+// smoothly instead of restarting from nothing. the old plan is handed back to be released off the
+// analysis thread since releasing takes the plan cache lock
+void adoptPendingPlan(jum_FFTSetup* fft) {
+  FFTPlan* old_plan;
+  FFTPlan* plan;
+
+  // only adopt once the last retired plan has been collected
+  if (__atomic_load_n(&fft->pending_plan, __ATOMIC_RELAXED) == NULL ||
+      __atomic_load_n(&fft->retired_plan, __ATOMIC_ACQUIRE) != NULL) {
+    return;
+  }
+  plan = __atomic_exchange_n(&fft->pending_plan, NULL, __ATOMIC_ACQ_REL);
+  if (plan == NULL) {
+    return;
+  }
+
+  old_plan = fft->plan;
+  resampleBins(fft->averaged, old_plan->luts.freqs, fft->num_bins, plan->luts.freqs,
+               plan->num_bins, fft->raw);
+  resampleBins(fft->result, old_plan->luts.freqs, fft->num_bins, plan->luts.freqs,
+               plan->num_bins, fft->raw);
+  resampleBins(fft->onset_state.prev, old_plan->luts.freqs, fft->num_bins, plan->luts.freqs,
+               plan->num_bins, fft->raw);
+
+  fft->plan = plan;
+  fft->num_bins = plan->num_bins;
+  fft->luts.freqs = plan->luts.freqs;
+  fft->luts.weights = plan->luts.weights;
+  applyQualityLevel(fft, fft->quality.level);
+  __atomic_store_n(&fft->retired_plan, old_plan, __ATOMIC_RELEASE);
+}
+
+// linearly interpolate per bin values onto bins at different frequencies, scratch needs to_sz
+void resampleBins(float* array, const float* from_freqs, ma_int32 from_sz, const float* to_freqs,
+                  ma_int32 to_sz, float* scratch) {
+  ma_int32 i, j = 0;
+  float t;
+
+  for (i = 0; i < to_sz; i++) {
+    while (j < from_sz - 2 && from_freqs[j + 1] < to_freqs[i]) {
+      j++;
+    }
+    if (from_sz < 2 || to_freqs[i] <= from_freqs[j]) {
+      scratch[i] = array[j];
+    } else if (to_freqs[i] >= from_freqs[j + 1]) {
+      scratch[i] = array[j + 1];
+    } else {
+      t = (to_freqs[i] - from_freqs[j]) / (from_freqs[j + 1] - from_freqs[j]);
+      scratch[i] = array[j] + t * (array[j + 1] - array[j]);
+    }
+  }
+  memcpy(array, scratch, to_sz * sizeof(float));
+}
+
+// add another output binned from the same transform, e.g. a compact view alongside a full one.
+// result is in the returned layout, updated by every jum_analyze call
+jum_FFTLayout* jum_addLayout(jum_FFTSetup* setup, const float freq_points[][2], ma_int32 freqs_sz,
+                             const float weight_points[][2], ma_int32 weights_sz,
+                             ma_int32 num_bins) {
+  jum_FFTLayout* layout;
+  float* arrays;
+
+  // arrays live in the same allocation as the layout
+  layout = (jum_FFTLayout*)calloc(1, sizeof(jum_FFTLayout) + 5 * num_bins * sizeof(float));
+  if (layout == NULL) {
+    return NULL;
+  }
+  arrays = (float*)(layout + 1);
+  layout->num_bins = num_bins;
+  layout->freqs = arrays;
+  layout->weights = arrays + num_bins;
+  layout->raw = arrays + 2 * num_bins;
+  layout->averaged = arrays + 3 * num_bins;
+  layout->result = arrays + 4 * num_bins;
+  layout->max = 2.5;
+  buildFreqTable(layout->freqs, num_bins, freq_points, freqs_sz);
+  buildWeightTable(layout->freqs, num_bins, weight_points, weights_sz, layout->weights);
+
+  layout->next = setup->layouts;
+  setup->layouts = layout;
+  return layout;
+}
+
+void jum_removeLayout(jum_FFTSetup* setup, jum_FFTLayout* layout) {
+  jum_FFTLayout** link;
+
+  for (link = &setup->layouts; *link != NULL; link = &(*link)->next) {
+    if (*link == layout) {
+      *link = layout->next;
+      free(layout);
+      return;
+    }
+  }
+}
+
+// same steps jum_analyze runs for its own bins, from the magnitudes it already computed
+void updateLayout(jum_FFTLayout* layout, const jum_FFTSetup* fft, float sample_rate,
+                  ma_int32 spread) {
+  TRACE_SCOPE(__func__);
+  readIntoBins(layout->raw, layout->freqs, layout->num_bins, fft->magnitudes, fft->pffft.sz,
+               sample_rate);
+  if (fft->pffft.sz != fft->plan->fft_sz) {
+    for (ma_int32 i = 0; i < layout->num_bins; i++) {
+      layout->raw[i] *= (float)fft->plan->fft_sz / fft->pffft.sz;
+    }
+  }
+  applyWeighting(layout->raw, layout->weights, layout->num_bins);
+  applyAveraging(layout->raw, layout->averaged, layout->num_bins);
+  applySmoothing(layout->averaged, layout->result, layout->num_bins, spread);
+  layout->max = normalizeArray(layout->result, layout->num_bins, layout->max, NULL);
+}
+
+// silent frame for a layout while the gate is skipping transforms, returns distance from floor
+float decayLayout(jum_FFTLayout* layout) {
+  float distance;
+
+  distance = decayToFloor(layout->averaged, layout->weights, layout->num_bins);
+  applySmoothing(layout->averaged, layout->result, layout->num_bins, SMOOTHING_SPREAD);
+  layout->max = normalizeArray(layout->result, layout->num_bins, layout->max, NULL);
+  return distance;
+}
+
+// name of the fft backend the full size plan picked, reduced quality plans may differ
+const char* jum_getFFTBackendName(jum_FFTSetup* setup) {
+  return setup->plan->backend->name;
+}
+
+void recordHistory(History* history, const float* result, ma_int32 num_bins) {
+  char* row;
+  ma_int32 i;
+  size_t elem_sz;
+
+  if (history->rows == NULL) {
+    return;
+  }
+  history->skipped++;
+  if (history->skipped < history->decimation) {
+    return;
+  }
+  history->skipped = 0;
+
+  history->head = (history->head + 1) % history->num_rows;
+  if (history->filled < history->num_rows) {
+    history->filled++;
+  }
+  row = (char*)history->rows + history->head * history->row_sz;
+  if (history->type == JUM_OUTPUT_F32) {
+    memcpy(row, result, num_bins * sizeof(float));
+    return;
+  }
+  elem_sz = outputTypeSize(history->type);
+  for (i = 0; i < num_bins; i++) {
+    storeOutput(row + i * elem_sz, history->type, result[i] * history->scale);
+  }
+}
+
+// have jum_analyze also write its final result to dst, pass NULL dst to stop
+void jum_setOutputTarget(jum_FFTSetup* setup, void* dst, size_t stride, jum_OutputType type,
+                         float scale, float offset) {
+  setup->output.dst = dst;
+  setup->output.stride = stride;
+  setup->output.type = type;
+  setup->output.scale = scale;
+  setup->output.offset = offset;
+}
+
+jum_FFTSetup* jum_initFFT(const float freq_points[][2], ma_int32 freqs_sz,
+                          const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
+                          ma_int32 num_bins) {
+  jum_FFTSetup* setup;
+  size_t sz;
+  void* mem;
+
+  // pffft aligned malloc is 64 byte aligned, which satisfies JUM_ALIGNMENT
+  sz = jum_FFTSetupSize(fft_sz, num_bins);
+  mem = pffft_aligned_malloc(sz);
+  if (mem == NULL) {
+    return NULL;
+  }
+
+  setup = jum_initFFTInPlace(mem, sz, freq_points, freqs_sz, weight_points, weights_sz, fft_sz,
+                             num_bins);
+  if (setup == NULL) {
+    pffft_aligned_free(mem);
+    return NULL;
+  }
+  setup->owns_memory = true;
+
+  return setup;
+}
+
+// number of bytes needed by jum_initFFTInPlace for the given configuration
+size_t jum_FFTSetupSize(ma_int32 fft_sz, ma_int32 num_bins) {
+  jum_FFTSetup layout;
+  return layoutFFTSetup(&layout, NULL, fft_sz, num_bins);
+}
+
+// set up analyzer in caller provided memory, mem must be JUM_ALIGNMENT aligned and at least
+// jum_FFTSetupSize bytes. no heap allocation is done apart from building a new shared plan
+jum_FFTSetup* jum_initFFTInPlace(void* mem, size_t mem_sz, const float freq_points[][2],
+                                 ma_int32 freqs_sz, const float weight_points[][2],
+                                 ma_int32 weights_sz, ma_int32 fft_sz, ma_int32 num_bins) {
+  jum_FFTSetup* setup;
+  size_t sz;
+
+  sz = jum_FFTSetupSize(fft_sz, num_bins);
+  if (mem == NULL || mem_sz < sz || ((size_t)mem % JUM_ALIGNMENT) != 0) {
+    printf("WARNING: memory passed to jum_initFFTInPlace is too small or misaligned\n");
+    return NULL;
+  }
+
+  memset(mem, 0, sz);
+  setup = (jum_FFTSetup*)mem;
+  layoutFFTSetup(setup, (char*)mem, fft_sz, num_bins);
+
+  setup->plan = acquireFFTPlan(freq_points, freqs_sz, weight_points, weights_sz, fft_sz, num_bins);
+  if (setup->plan == NULL) {
+    printf("Failed to create fft plan\n");
+    return NULL;
+  }
+  setup->luts = setup->plan->luts;
+  setup->pffft.setup = setup->plan->setup;
+  setup->pffft.backend = setup->plan->backend;
+  setup->pffft.sz = fft_sz;
+
+  setup->max = 2.5;
+  setup->pos = 0;
+  setup->num_bins = num_bins;
+  setup->max_bins = num_bins;
+  setup->level = 0;
+  initOnsetTracker(&setup->onset_state);
+  setup->gate.last_end = -1;
+  setup->owns_memory = false;
+
+  return setup;
+}
+
+void jum_deinitFFT(jum_FFTSetup* setup) {
+  if (setup != NULL) {
+    jum_setTimeBudget(setup, 0);
+    while (setup->layouts != NULL) {
+      jum_removeLayout(setup, setup->layouts);
+    }
+    if (setup->pending_plan != NULL) {
+      releaseFFTPlan(setup->pending_plan);
+    }
+    if (setup->retired_plan != NULL) {
+      releaseFFTPlan(setup->retired_plan);
+    }
+    deinitPFFFT(&setup->pffft);
+    releaseFFTPlan(setup->plan);
+    pffft_aligned_free(setup->history.rows);
+
+    // arrays all live in the same block as the setup
+    if (setup->owns_memory) {
+      pffft_aligned_free(setup);
+    }
+
+    setup = NULL;
+  }
+}
+
+size_t alignSize(size_t size) {
+  return (size + JUM_ALIGNMENT - 1) & ~(size_t)(JUM_ALIGNMENT - 1);
+}
+
+// reserve count floats at offset, returns NULL when only measuring (no base)
+float* arenaArray(char* base, size_t* offset, size_t count) {
+  float* array = base != NULL ? (float*)(base + *offset) : NULL;
+  *offset += alignSize(count * sizeof(float));
+  return array;
+}
+
+// single place defining the arena layout, used for both sizing and init. setup struct comes first,
+// then the arrays touched every frame grouped together, each starting on a JUM_ALIGNMENT boundary
+size_t layoutFFTSetup(jum_FFTSetup* setup, char* base, ma_int32 fft_sz, ma_int32 num_bins) {
+  size_t offset = alignSize(sizeof(jum_FFTSetup));
+
+  setup->pffft.in = arenaArray(base, &offset, fft_sz);
+  // ordered real transform outputs fft_sz floats (fft_sz/2 complex pairs)
+  setup->pffft.out = arenaArray(base, &offset, fft_sz);
+  setup->pffft.work = arenaArray(base, &offset, fft_sz);
+  setup->magnitudes = arenaArray(base, &offset, fft_sz / 2);
+  setup->raw = arenaArray(base, &offset, num_bins);
+  setup->averaged = arenaArray(base, &offset, num_bins);
+  setup->result = arenaArray(base, &offset, num_bins);
+  setup->onset_state.prev = arenaArray(base, &offset, num_bins);
+
+  return offset;
+}
+
+// find a plan matching the given configuration or build a new one, plans are refcounted
+FFTPlan* acquireFFTPlan(const float freq_points[][2], ma_int32 freqs_sz,
+                        const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
+                        ma_int32 num_bins) {
+  FFTPlan* plan;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  for (plan = plan_cache; plan != NULL; plan = plan->next) {
+    if (plan->fft_sz == fft_sz && plan->num_bins == num_bins && plan->freqs_sz == freqs_sz &&
+        plan->weights_sz == weights_sz &&
+        memcmp(plan->freq_points, freq_points, freqs_sz * sizeof(float[2])) == 0 &&
+        memcmp(plan->weight_points, weight_points, weights_sz * sizeof(float[2])) == 0) {
+      plan->refcount++;
+      pthread_mutex_unlock(&plan_cache_mutex);
+      return plan;
+    }
+  }
+
+  plan = (FFTPlan*)malloc(sizeof(FFTPlan));
+  plan->backend = createFFTSetup(fft_sz, &plan->setup);
+  if (plan->backend == NULL) {
+    free(plan);
+    pthread_mutex_unlock(&plan_cache_mutex);
+    return NULL;
+  }
+  plan->fft_sz = fft_sz;
+  plan->num_bins = num_bins;
+  plan->freqs_sz = freqs_sz;
+  plan->freq_points = malloc(freqs_sz * sizeof(float[2]));
+  memcpy(plan->freq_points, freq_points, freqs_sz * sizeof(float[2]));
+  plan->weights_sz = weights_sz;
+  plan->weight_points = malloc(weights_sz * sizeof(float[2]));
+  memcpy(plan->weight_points, weight_points, weights_sz * sizeof(float[2]));
+
+  plan->luts.freqs = (float*)malloc(num_bins * sizeof(float));
+  buildFreqTable(plan->luts.freqs, num_bins, freq_points, freqs_sz);
+  plan->luts.weights = (float*)malloc(num_bins * sizeof(float));
+  buildWeightTable(plan->luts.freqs, num_bins, weight_points, weights_sz, plan->luts.weights);
+  plan->luts.hamming = (float*)malloc(fft_sz * sizeof(float));
+  buildHammingWindow(plan->luts.hamming, fft_sz);
+
+  plan->refcount = 1;
+  plan->next = plan_cache;
+  plan_cache = plan;
+  pthread_mutex_unlock(&plan_cache_mutex);
+
+  return plan;
+}
+
+void releaseFFTPlan(FFTPlan* plan) {
+  FFTPlan** link;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  plan->refcount--;
+  if (plan->refcount > 0) {
+    pthread_mutex_unlock(&plan_cache_mutex);
+    return;
+  }
+  // last user, unlink from cache and free
+  for (link = &plan_cache; *link != NULL; link = &(*link)->next) {
+    if (*link == plan) {
+      *link = plan->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&plan_cache_mutex);
+
+  plan->backend->destroy(plan->setup);
+  free(plan->luts.freqs);
+  free(plan->luts.weights);
+  free(plan->luts.hamming);
+  free(plan->freq_points);
+  free(plan->weight_points);
+  free(plan);
+}
+
+// setup is owned by the shared plan and the inout buffers by the arena, nothing to free
+void deinitPFFFT(PFFFTInfo* info) {
+  if (info) {
+    info->setup = NULL;
+    info->backend = NULL;
+    info->in = NULL;
+    info->out = NULL;
+    info->work = NULL;
+  }
+}
+
+// record what is captured (capture, duplex and push modes) or played (playback mode) from now on to
+// filepath. the audio callback only copies into a staging ring, a writer thread does all the file
+// io, and anything that doesn't fit in the ring is dropped and reported rather than waited for
+ma_int32 jum_startRecording(jum_AudioSetup* setup, const char* filepath, jum_RecordFormat format) {
+  Recorder* recorder = &setup->recorder;
+  ma_encoder_config config;
+  ma_result result;
+  int flags;
+
+  if (!setup->playback_open && !setup->capture_open && setup->mode != AUDIO_MODE_PUSH) {
+    printf("WARNING: attempting to record without a device open\n");
+    return -2;
+  }
+  if (__atomic_load_n(&recorder->state, __ATOMIC_ACQUIRE) != RECORD_IDLE) {
+    printf("WARNING: already recording\n");
+    return -2;
+  }
+
+  recorder->channels = setup->info.channels;
+  recorder->format = format;
+  if (format == JUM_RECORD_WAV) {
+    config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, setup->info.channels,
+                                    setup->info.sample_rate);
+    result = ma_encoder_init_file(filepath, &config, &recorder->encoder);
+    if (result != MA_SUCCESS) {
+      printf("WARNING: Failed to open \"%s\" for recording\n", filepath);
+      return -1;
+    }
+  } else {
+    flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (format == JUM_RECORD_RAW_DIRECT) {
+      flags |= O_DIRECT;
+    }
+#endif
+    recorder->fd = open(filepath, flags, 0644);
+    if (recorder->fd < 0) {
+      printf("WARNING: Failed to open \"%s\" for recording\n", filepath);
+      return -1;
+    }
+    recorder->allocated = 0;
+  }
+
+  recorder->ring = (float*)malloc(RECORD_RING_FRAMES * recorder->channels * sizeof(float));
+  if (posix_memalign((void**)&recorder->batch, RECORD_DIRECT_ALIGN,
+                     RECORD_BATCH_FRAMES * recorder->channels * sizeof(float)) != 0) {
+    recorder->batch = NULL;
+  }
+  recorder->write_count = 0;
+  recorder->read_count = 0;
+  recorder->dropped = 0;
+  recorder->written = 0;
+  recorder->failed = false;
+  recorder->stop = false;
+  if (recorder->ring == NULL || recorder->batch == NULL ||
+      pthread_create(&recorder->thread, NULL, recordWriter, recorder) != 0) {
+    printf("WARNING: Failed to start recording\n");
+    closeRecording(recorder);
+    return -1;
+  }
+  __atomic_store_n(&recorder->state, RECORD_ACTIVE, __ATOMIC_RELEASE);
+  return 0;
+}
 
-  printf("Starting capture of device [%d]'%s'\n", device_index, selected_device_name);
-  jum_printAudioInfo(setup->info);
-#endif
+// stop taking audio, then wait for the writer thread to flush what is staged and close the file
+ma_int32 jum_stopRecording(jum_AudioSetup* setup) {
+  Recorder* recorder = &setup->recorder;
+  ma_int32 expected = RECORD_ACTIVE;
 
+  if (__atomic_load_n(&recorder->state, __ATOMIC_ACQUIRE) == RECORD_IDLE) {
+    return -2;
+  }
+  // waits out an append in progress, which is only a copy
+  while (!__atomic_compare_exchange_n(&recorder->state, &expected, RECORD_IDLE, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+    expected = RECORD_ACTIVE;
+  }
+  __atomic_store_n(&recorder->stop, true, __ATOMIC_RELEASE);
+  pthread_join(recorder->thread, NULL);
+  closeRecording(recorder);
   return 0;
 }
 
-void jum_printAudioInfo(AudioInfo info) {
-  switch (info.format) {
-    case (ma_format_u8):
-      printf("ma_format_u8\n");
-      break;
-    case (ma_format_s16):
-      printf("ma_format_s16\n");
-      break;
-    case (ma_format_s24):
-      printf("ma_format_s24\n");
-      break;
-    case (ma_format_s32):
-      printf("ma_format_s32\n");
-      break;
-    case (ma_format_f32):
-      printf("ma_format_f32\n");
-      break;
-    default:
-      printf("unknown\n");
-      break;
+void jum_getRecordingStatus(jum_AudioSetup* setup, jum_RecordingStatus* status) {
+  status->recording = __atomic_load_n(&setup->recorder.state, __ATOMIC_ACQUIRE) != RECORD_IDLE;
+  status->frames_written = __atomic_load_n(&setup->recorder.written, __ATOMIC_RELAXED);
+  status->frames_dropped = __atomic_load_n(&setup->recorder.dropped, __ATOMIC_RELAXED);
+}
+
+// runs on the audio thread, never blocks. frames that don't fit in the ring are counted as dropped
+void recordFrames(Recorder* recorder, const float* frames, ma_uint32 frame_count) {
+  ma_int32 expected = RECORD_ACTIVE;
+  ma_uint64 write_count, pos;
+  ma_uint32 first;
+
+  if (!__atomic_compare_exchange_n(&recorder->state, &expected, RECORD_APPENDING, false,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    // lost to another append rather than not recording, report it instead of losing it quietly
+    if (expected == RECORD_APPENDING) {
+      __atomic_fetch_add(&recorder->dropped, frame_count, __ATOMIC_RELAXED);
+    }
+    return;
   }
-  printf("num channels %d\n", info.channels);
-  printf("sample rate %d\n", info.sample_rate);
-  printf("bytes per frame %d\n", info.bytes_per_frame);
+  write_count = __atomic_load_n(&recorder->write_count, __ATOMIC_RELAXED);
+  if (write_count + frame_count - __atomic_load_n(&recorder->read_count, __ATOMIC_ACQUIRE) >
+      RECORD_RING_FRAMES) {
+    __atomic_fetch_add(&recorder->dropped, frame_count, __ATOMIC_RELAXED);
+  } else {
+    pos = write_count & (RECORD_RING_FRAMES - 1);
+    first = RECORD_RING_FRAMES - pos < frame_count ? RECORD_RING_FRAMES - pos : frame_count;
+    memcpy(&recorder->ring[pos * recorder->channels], frames,
+           first * recorder->channels * sizeof(float));
+    memcpy(recorder->ring, &frames[first * recorder->channels],
+           (frame_count - first) * recorder->channels * sizeof(float));
+    __atomic_store_n(&recorder->write_count, write_count + frame_count, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&recorder->state, RECORD_ACTIVE, __ATOMIC_RELEASE);
 }
 
-// perform fft calculation, result is written to fft->result
-void jum_analyze(jum_FFTSetup* fft, jum_AudioSetup* audio, ma_uint32 msec) {
-  ma_int32 reader_pos;
-  ma_int32 temp_pos;
+// moves full batches from the staging ring to disk, and whatever is left once told to stop
+void* recordWriter(void* arg) {
+  Recorder* recorder = (Recorder*)arg;
+  struct timespec poll = {0, RECORD_POLL_MS * 1000000L};
+  ma_uint64 read_count, available, pos, dropped;
+  ma_uint64 reported = 0;
+  ma_uint32 count, first;
+  bool stopping;
+
+  do {
+    stopping = __atomic_load_n(&recorder->stop, __ATOMIC_ACQUIRE);
+    read_count = recorder->read_count;
+    available = __atomic_load_n(&recorder->write_count, __ATOMIC_ACQUIRE) - read_count;
+    // only whole batches while recording, so every write but the tail at stop is block aligned
+    while (available >= RECORD_BATCH_FRAMES || (stopping && available > 0)) {
+      count = available < RECORD_BATCH_FRAMES ? available : RECORD_BATCH_FRAMES;
+      pos = read_count & (RECORD_RING_FRAMES - 1);
+      first = RECORD_RING_FRAMES - pos < count ? RECORD_RING_FRAMES - pos : count;
+      memcpy(recorder->batch, &recorder->ring[pos * recorder->channels],
+             first * recorder->channels * sizeof(float));
+      memcpy(&recorder->batch[first * recorder->channels], recorder->ring,
+             (count - first) * recorder->channels * sizeof(float));
+      read_count += count;
+      available -= count;
+      // space is handed back before the slow part
+      __atomic_store_n(&recorder->read_count, read_count, __ATOMIC_RELEASE);
+      writeRecordBatch(recorder, count);
+    }
 
-  // increment pointer position (in 32 bit float samples) based on given time
-  fft->pos += ((audio->info.sample_rate * msec) / 1000L) * audio->info.channels;
-  if (fft->pos >= audio->buffer.sz) {
-    fft->pos -= audio->buffer.sz;
-  }
+    dropped = __atomic_load_n(&recorder->dropped, __ATOMIC_RELAXED);
+    if (dropped != reported) {
+      printf("WARNING: recording dropped %llu frames, disk isn't keeping up\n",
+             (unsigned long long)(dropped - reported));
+      reported = dropped;
+    }
+    if (!stopping) {
+      nanosleep(&poll, NULL);
+    }
+  } while (!stopping);
+  return NULL;
+}
 
-  // this blocks end of audio data callback, so keep as short as possible
-  // read necessary data from the datacallback thread
-  sem_wait(&audio->control.mutex);
-  if (audio->control.new_data_flag) {  // data written to audio stream
-    reader_pos = audio->control.reader_pos;
-    audio->control.new_data_flag = 0;
-  } else {
-    reader_pos = -1;  // no new reader pos
+void writeRecordBatch(Recorder* recorder, ma_uint32 count) {
+  size_t bytes = (size_t)count * recorder->channels * sizeof(float);
+  ma_uint64 offset;
+  ssize_t result;
+  size_t done = 0;
+  bool direct = false;
+
+  if (recorder->failed) {
+    __atomic_fetch_add(&recorder->dropped, count, __ATOMIC_RELAXED);
+    return;
+  }
+  if (recorder->format == JUM_RECORD_WAV) {
+    ma_encoder_write_pcm_frames(&recorder->encoder, recorder->batch, count, NULL);
+    __atomic_fetch_add(&recorder->written, count, __ATOMIC_RELAXED);
+    return;
   }
-  sem_post(&audio->control.mutex);
 
-  // if there was a new reader position
-  if (reader_pos >= 0) {
-    // if the fft position is lagging behind or too far ahead of reader, resync
-    if (fft->pos < reader_pos || (fft->pos - reader_pos) > MAX_DESYNC) {
-      fft->pos = reader_pos;
+  // extend the file ahead of the writes so they don't have to allocate blocks as they go
+  offset = recorder->written * recorder->channels * sizeof(float);
+  if (offset + bytes > recorder->allocated) {
+    if (posix_fallocate(recorder->fd, recorder->allocated, RECORD_PREALLOC_BYTES) == 0) {
+      recorder->allocated += RECORD_PREALLOC_BYTES;
+    } else {
+      recorder->allocated = (ma_uint64)-1;  // not supported here, don't keep trying
+    }
+  }
+#ifdef O_DIRECT
+  // O_DIRECT needs whole blocks, the tail written at stop is padded with silence and the padding
+  // is trimmed off again by closeRecording
+  direct = recorder->format == JUM_RECORD_RAW_DIRECT;
+  if (direct && bytes % RECORD_DIRECT_ALIGN != 0) {
+    memset((char*)recorder->batch + bytes, 0, RECORD_DIRECT_ALIGN - bytes % RECORD_DIRECT_ALIGN);
+    bytes += RECORD_DIRECT_ALIGN - bytes % RECORD_DIRECT_ALIGN;
+  }
+#endif
+  while (done < bytes) {
+    result = write(recorder->fd, (const char*)recorder->batch + done, bytes - done);
+    // a short O_DIRECT write leaves the offset unaligned, every write after it would fail
+    if (result < 0 || (direct && (size_t)result != bytes)) {
+      printf("WARNING: Failed to write recording, dropping the rest\n");
+      recorder->failed = true;
+      __atomic_fetch_add(&recorder->dropped, count, __ATOMIC_RELAXED);
+      return;
     }
+    done += result;
   }
+  __atomic_fetch_add(&recorder->written, count, __ATOMIC_RELAXED);
+}
 
-  // temp position since fft_pos keeps up with actual playback rate
-  // if we are capturing, then delay one buffer size behind reader
-  if (audio->mode == AUDIO_MODE_CAPTURE) {
-    temp_pos = fft->pos - fft->pffft.sz * audio->info.channels;
+// close the file, raw files are trimmed back to what was written after preallocating
+void closeRecording(Recorder* recorder) {
+  if (recorder->format == JUM_RECORD_WAV) {
+    ma_encoder_uninit(&recorder->encoder);
   } else {
-    temp_pos = fft->pos;
+    if (ftruncate(recorder->fd, recorder->written * recorder->channels * sizeof(float)) != 0) {
+      printf("WARNING: Failed to trim recording\n");
+    }
+    close(recorder->fd);
   }
+  free(recorder->ring);
+  free(recorder->batch);
+  recorder->ring = NULL;
+  recorder->batch = NULL;
+}
 
-  if (temp_pos < 0) {
-    temp_pos = audio->buffer.sz + temp_pos;
+// write everything still in the trace rings to filepath as chrome trace json, open it in
+// chrome://tracing or ui.perfetto.dev. safe to call while the traced threads keep running
+ma_int32 jum_dumpTrace(const char* filepath) {
+#ifdef JUMAUDIO_TRACE
+  TraceRing* ring;
+  TraceEvent event;
+  ma_uint64 head, i;
+  ma_uint32 num_rings, r;
+  const char* separator = "";
+  FILE* file;
+
+  file = fopen(filepath, "w");
+  if (file == NULL) {
+    printf("WARNING: Failed to open \"%s\" for trace\n", filepath);
+    return -1;
   }
+  num_rings = __atomic_load_n(&trace_num_rings, __ATOMIC_ACQUIRE);
+  if (num_rings > TRACE_THREADS) {
+    num_rings = TRACE_THREADS;
+  }
+
+  fprintf(file, "{\"traceEvents\":[");
+  for (r = 0; r < num_rings; r++) {
+    ring = &trace_rings[r];
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    for (i = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0; i < head; i++) {
+      event = ring->events[i % TRACE_EVENTS];
+      // drop the event if its thread lapped the ring while it was being copied
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&ring->head, __ATOMIC_RELAXED) >= i + TRACE_EVENTS) {
+        continue;
+      }
+      fprintf(file,
+              "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+              "\"dur\":%.3f}",
+              separator, event.name, r, event.start_ns / 1000.0,
+              (event.end_ns - event.start_ns) / 1000.0);
+      separator = ",";
+    }
+  }
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  return 0;
+#else
+  (void)filepath;
+  printf("WARNING: jum_dumpTrace needs jumaudio built with JUMAUDIO_TRACE\n");
+  return -2;
+#endif
+}
 
-  readIntoFFTBuffer(audio->buffer.buf, temp_pos, audio->buffer.sz, fft->pffft.in, fft->pffft.sz,
-                    fft->luts.hamming, audio->info.channels);
-  fft->level = averageLevel(fft->pffft.in, fft->pffft.sz, fft->level);
-  pffft_transform_ordered(fft->pffft.setup, fft->pffft.in, fft->pffft.out, NULL, PFFFT_FORWARD);
-
-  readIntoBins(fft->raw, fft->luts.freqs, fft->num_bins, fft->pffft.out, fft->pffft.sz,
-               audio->info.sample_rate);
-  applyWeighting(fft->raw, fft->luts.weights, fft->num_bins);
-  applyAveraging(fft->raw, fft->averaged, fft->num_bins);
-  applySmoothing(fft->averaged, fft->result, fft->num_bins);
-  fft->max = normalizeArray(fft->result, fft->num_bins, fft->max);
+#ifdef JUMAUDIO_TRACE
+TraceScope traceBegin(const char* name) {
+  TraceScope scope;
+  scope.name = name;
+  scope.start_ns = traceNow();
+  return scope;
 }
 
-// apply windowing and copy to fft buffer
-void readIntoFFTBuffer(const float* samples_in, ma_int32 in_pos, ma_int32 in_size,
-                       float* samples_out, ma_int32 out_size, const float* hamming,
-                       ma_int32 channels) {
-  ma_int32 i;
-  for (i = 0; i < out_size; i++) {
-    samples_out[i] = samples_in[in_pos % in_size] * hamming[i];
-    in_pos++;
-    if (channels == 2) {  // two channels, use average
-      samples_out[i] += samples_in[in_pos % in_size] * hamming[i];
-      samples_out[i] /= 2;
-      in_pos++;
+// only touches this thread's ring, so the audio thread never waits on anything
+void traceEnd(TraceScope* scope) {
+  TraceEvent* event;
+  ma_uint32 index;
+  ma_uint64 head;
+
+  if (trace_ring == NULL) {
+    if (trace_untraced) {
+      return;
     }
-  }
+    index = __atomic_fetch_add(&trace_num_rings, 1, __ATOMIC_ACQ_REL);
+    if (index >= TRACE_THREADS) {
+      trace_untraced = true;
+      return;
+    }
+    trace_ring = &trace_rings[index];
+  }
+  head = __atomic_load_n(&trace_ring->head, __ATOMIC_RELAXED);
+  event = &trace_ring->events[head % TRACE_EVENTS];
+  event->name = scope->name;
+  event->start_ns = scope->start_ns;
+  event->end_ns = traceNow();
+  __atomic_store_n(&trace_ring->head, head + 1, __ATOMIC_RELEASE);
 }
 
-float averageLevel(const float* samples, ma_int32 sz, float prev_level) {
-  ma_int32 i;
-  float level = 0;
-  for (i = 0; i < sz; i++) {
-    level += samples[i] * samples[i];
-  }
-  level /= sz;
-  level = sqrtf(level) * 5;
+ma_uint64 traceNow(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (ma_uint64)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
 
-  if (level > prev_level)
-    level = (0.5F) * prev_level + ((1 - 0.5F) * level);
-  else
-    level = (0.9F) * prev_level + ((1 - 0.9F) * level);
+// fft backends, tried in order and the first supported by the cpu and size is used
+#if defined(__x86_64__) || defined(__i386__)
+const FFTBackend* const jum_fft_backends[] = {&jum_avx512_fft_backend, &jum_avx2_fft_backend,
+                                              &jum_pffft_backend};
+#else
+const FFTBackend* const jum_fft_backends[] = {&jum_pffft_backend};
+#endif
+const ma_int32 jum_num_fft_backends = sizeof(jum_fft_backends) / sizeof(jum_fft_backends[0]);
 
-  return level;
+// pick backend for this size and create its setup
+const FFTBackend* createFFTSetup(ma_int32 size, void** setup) {
+  ma_int32 i;
+  for (i = 0; i < jum_num_fft_backends; i++) {
+    if (jum_fft_backends[i]->supported()) {
+      *setup = jum_fft_backends[i]->create(size);
+      if (*setup != NULL) {
+        return jum_fft_backends[i];
+      }
+    }
+  }
+  return NULL;
 }
 
-// take equally distributed fft samples and average into bins
-void readIntoBins(float* out, const float* freqs, ma_int32 out_sz, const float* fft,
-                  ma_int32 fft_sz, float sample_rate) {
-  float re, im, freq;
-  ma_int32 current_bin = 0;
-  ma_int32 samples_in_bin = 0;
-  ma_int32 i;
-  out[0] = 0;
+bool pffftSupported(void) {
+  return true;
+}
 
-  // read from raw output into bins and average
-  for (i = 0; i < fft_sz / 2; i++) {
-    re = fft[i * 2];
-    im = fft[i * 2 + 1];
+void* pffftCreate(ma_int32 size) {
+  // pffft real transforms need a multiple of 32 samples, it asserts rather than failing
+  if (size <= 0 || size % 32 != 0) {
+    return NULL;
+  }
+  return pffft_new_setup(size, PFFFT_REAL);
+}
 
-    // frequency for this sample
-    freq = (i * (sample_rate / 2)) / (fft_sz / 2);
-    // fits into current bin
-    if (freq > freqs[current_bin]) {       // passed current bin
-      out[current_bin] /= samples_in_bin;  // take average
-      samples_in_bin = 0;
-      current_bin++;
+void pffftDestroy(void* setup) {
+  pffft_destroy_setup((PFFFT_Setup*)setup);
+}
 
-      while (freq > freqs[current_bin]) {
-        if (current_bin >= out_sz)
-          break;
-        // if skipping multiple bins then duplicate prev value TODO could smooth better?
-        if (current_bin != 0)
-          out[current_bin] = out[current_bin - 1];
-        current_bin++;
-      }
-      if (current_bin >= out_sz)
-        break;
+void pffftTransform(void* setup, const float* in, float* out, float* work) {
+  pffft_transform_ordered((PFFFT_Setup*)setup, in, out, work, PFFFT_FORWARD);
+}
 
-      out[current_bin] = 0;  // set to 0 so that we can +=
-    }
+const FFTBackend jum_pffft_backend = {"pffft", pffftSupported, pffftCreate, pffftDestroy,
+                                      pffftTransform};
+
+#if defined(__x86_64__) || defined(__i386__)
+// radix-2 stockham real fft on split re/im arrays. the n point real input is packed into an n/2
+// point complex fft, every stage reads both halves of the buffer contiguously so each simd lane
+// does one butterfly, and the output comes out in natural order without a bit reversal pass
+struct simd_fft {
+  ma_int32 n;            // real transform size
+  ma_int32 m;            // complex transform size, n/2
+  ma_int32 width;        // floats per vector
+  ma_int32 stages;       // log2(m)
+  float* tw_re;          // w_m^k for k < m/2
+  float* tw_im;
+  float* lane_tw_re[4];  // twiddle for every lane of stages with fewer than width butterflies
+  float* lane_tw_im[4];  // sharing a twiddle, indexed by log2 of that count
+  float* post_re;        // w_n^k for k < m, for splitting the packed result
+  float* post_im;
+  ma_int32 perm[4][32];  // avx512 interleave indices per stage, see avx512Stage
+};
+
+void* simdFFTCreate(ma_int32 size, ma_int32 width) {
+  SimdFFT* f;
+  ma_int32 m, k, j, s, stage;
+  double angle;
+
+  // power of 2 with at least one vector per half of the complex buffer
+  m = size / 2;
+  if (size < 4 * width || (size & (size - 1)) != 0) {
+    return NULL;
+  }
 
-    out[current_bin] += sqrtf((re * re) + (im * im));
-    samples_in_bin++;
+  f = (SimdFFT*)calloc(1, sizeof(SimdFFT));
+  if (f == NULL) {
+    return NULL;
+  }
+  f->n = size;
+  f->m = m;
+  f->width = width;
+  for (k = m; k > 1; k >>= 1) {
+    f->stages++;
   }
-}
 
-void applyWeighting(float* data, const float* weights, ma_int32 size) {
-  ma_int32 i;
-  for (i = 0; i < size; i++) {
-    // log scaling
-    data[i] = log10f(data[i] + 0.5) + 0.31;  // prevent negative numbers
-    // apply weighting
-    data[i] *= weights[i];
+  f->tw_re = (float*)pffft_aligned_malloc(m / 2 * sizeof(float));
+  f->tw_im = (float*)pffft_aligned_malloc(m / 2 * sizeof(float));
+  if (f->tw_re == NULL || f->tw_im == NULL) {
+    simdFFTDestroy(f);
+    return NULL;
+  }
+  for (k = 0; k < m / 2; k++) {
+    angle = -2 * M_PI * k / m;
+    f->tw_re[k] = cos(angle);
+    f->tw_im[k] = sin(angle);
   }
-}
 
-void applyAveraging(const float* current, float* averaged, ma_int32 size) {
-  ma_int32 i;
-  for (i = 0; i < size; i++) {
-    // apply exponential moving average
-    if (current[i] > averaged[i]) {
-      // jump up quickly
-      averaged[i] = (0.2F) * averaged[i] + ((1 - 0.2F) * current[i]);
-    } else {
-      // fall down slowly
-      averaged[i] = (0.9F) * averaged[i] + ((1 - 0.9F) * current[i]);
+  for (stage = 0, s = 1; s < width; stage++, s <<= 1) {
+    f->lane_tw_re[stage] = (float*)pffft_aligned_malloc(m / 2 * sizeof(float));
+    f->lane_tw_im[stage] = (float*)pffft_aligned_malloc(m / 2 * sizeof(float));
+    if (f->lane_tw_re[stage] == NULL || f->lane_tw_im[stage] == NULL) {
+      simdFFTDestroy(f);
+      return NULL;
+    }
+    for (j = 0; j < m / 2; j++) {
+      f->lane_tw_re[stage][j] = f->tw_re[(j / s) * s];
+      f->lane_tw_im[stage][j] = f->tw_im[(j / s) * s];
+    }
+    // output position t of a 2*width block takes sum lane or diff lane (offset by 16)
+    for (j = 0; j < 2 * width && width == 16; j++) {
+      k = j / s;
+      f->perm[stage][j] = (k % 2) * 16 + (k / 2) * s + j % s;
     }
   }
-}
 
-void applySmoothing(const float* in, float* out, ma_int32 size) {
-  ma_int32 i, j, sample_width;
-  float x;
-  for (i = 0; i < size; i++) {
-    // smooth between frequency bins
-    // number of surrounding bins in each direction to take avg of
-    x = ((float)size - (float)i) / ((float)size);
-    sample_width = (ma_int32)(x * 7) + 2;
-    for (j = 0; j < sample_width; j++) {
-      if (i - j > 0)
-        out[i] += in[i - j] / (sample_width * 2);
-      if (i + j < size)
-        out[i] += in[i + j] / (sample_width * 2);
-    }
+  f->post_re = (float*)pffft_aligned_malloc(m * sizeof(float));
+  f->post_im = (float*)pffft_aligned_malloc(m * sizeof(float));
+  if (f->post_re == NULL || f->post_im == NULL) {
+    simdFFTDestroy(f);
+    return NULL;
+  }
+  for (k = 0; k < m; k++) {
+    angle = -2 * M_PI * k / size;
+    f->post_re[k] = cos(angle);
+    f->post_im[k] = sin(angle);
   }
+
+  return f;
 }
 
-float normalizeArray(float* array, ma_int32 size, float max) {
+void simdFFTDestroy(void* setup) {
+  SimdFFT* f = (SimdFFT*)setup;
   ma_int32 i;
-  // first pass check if max provided has been exceeded
-  for (i = 0; i < size; i++) {
-    if (array[i] > max)
-      max = array[i];
+  if (f == NULL) {
+    return;
   }
-  // second pass, normalize result based on max, min is always 0
-  for (i = 0; i < size; i++) {
-    array[i] = (array[i] - 0) / (max - 0);
+  pffft_aligned_free(f->tw_re);
+  pffft_aligned_free(f->tw_im);
+  for (i = 0; i < 4; i++) {
+    pffft_aligned_free(f->lane_tw_re[i]);
+    pffft_aligned_free(f->lane_tw_im[i]);
   }
-  return max;
+  pffft_aligned_free(f->post_re);
+  pffft_aligned_free(f->post_im);
+  free(f);
 }
 
-jum_FFTSetup* jum_initFFT(const float freq_points[][2], ma_int32 freqs_sz,
-                          const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
-                          ma_int32 num_bins) {
-
-  jum_FFTSetup* setup = (jum_FFTSetup*)malloc(sizeof(jum_FFTSetup));
-
-  initPFFFT(&setup->pffft, fft_sz);
-  setup->raw = (float*)calloc(num_bins, sizeof(float));
-  setup->averaged = (float*)calloc(num_bins, sizeof(float));
-  setup->result = (float*)calloc(num_bins, sizeof(float));
+// split the packed complex result z into the real transform, out is ordered like pffft:
+// dc, nyquist, then re/im pairs. handles bins [k, m)
+void simdFFTPostScalar(const SimdFFT* f, const float* zr, const float* zi, float* out,
+                       ma_int32 k) {
+  float er, ei, or_, oi;
+  for (; k < f->m; k++) {
+    er = (zr[k] + zr[f->m - k]) * 0.5F;
+    ei = (zi[k] - zi[f->m - k]) * 0.5F;
+    or_ = (zi[k] + zi[f->m - k]) * 0.5F;
+    oi = -(zr[k] - zr[f->m - k]) * 0.5F;
+    out[2 * k] = er + f->post_re[k] * or_ - f->post_im[k] * oi;
+    out[2 * k + 1] = ei + f->post_re[k] * oi + f->post_im[k] * or_;
+  }
+}
 
-  setup->luts.freqs = (float*)malloc(num_bins * sizeof(float));
-  buildFreqTable(setup->luts.freqs, num_bins, freq_points, freqs_sz);
-  setup->luts.weights = (float*)malloc(num_bins * sizeof(float));
-  buildWeightTable(setup->luts.freqs, num_bins, weight_points, weights_sz, setup->luts.weights);
-  setup->luts.hamming = (float*)malloc(fft_sz * sizeof(float));
-  buildHammingWindow(setup->luts.hamming, fft_sz);
+bool avx2Supported(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
 
-  setup->max = 2.5;
-  setup->pos = 0;
-  setup->num_bins = num_bins;
-  setup->level = 0;
+void* avx2Create(ma_int32 size) {
+  return simdFFTCreate(size, 8);
+}
 
-  return setup;
+// one butterfly per lane, s butterflies share a twiddle. sums go to y[2j - q], diffs s later
+__attribute__((target("avx2,fma"))) void avx2Stage(const SimdFFT* f, ma_int32 stage, ma_int32 s,
+                                                   const float* xr, const float* xi, float* yr,
+                                                   float* yi) {
+  ma_int32 half = f->m / 2;
+  ma_int32 j, q, o;
+  __m256 ar, ai, br, bi, sr, si, dr, di, wr, wi, tr, ti, lo, hi;
+
+  for (j = 0; j < half; j += 8) {
+    ar = _mm256_load_ps(&xr[j]);
+    ai = _mm256_load_ps(&xi[j]);
+    br = _mm256_load_ps(&xr[j + half]);
+    bi = _mm256_load_ps(&xi[j + half]);
+    sr = _mm256_add_ps(ar, br);
+    si = _mm256_add_ps(ai, bi);
+    dr = _mm256_sub_ps(ar, br);
+    di = _mm256_sub_ps(ai, bi);
+    if (s >= 8) {
+      q = j & (s - 1);
+      wr = _mm256_set1_ps(f->tw_re[j - q]);
+      wi = _mm256_set1_ps(f->tw_im[j - q]);
+    } else {
+      wr = _mm256_load_ps(&f->lane_tw_re[stage][j]);
+      wi = _mm256_load_ps(&f->lane_tw_im[stage][j]);
+    }
+    tr = _mm256_fmsub_ps(dr, wr, _mm256_mul_ps(di, wi));
+    ti = _mm256_fmadd_ps(dr, wi, _mm256_mul_ps(di, wr));
+
+    if (s >= 8) {
+      o = 2 * j - q;
+      _mm256_store_ps(&yr[o], sr);
+      _mm256_store_ps(&yi[o], si);
+      _mm256_store_ps(&yr[o + s], tr);
+      _mm256_store_ps(&yi[o + s], ti);
+      continue;
+    }
+    // interleave sum and diff in chunks of s into y[2j, 2j + 16)
+#define AVX2_INTERLEAVE(a, b, out)                                                   \
+  if (s == 1) {                                                                      \
+    lo = _mm256_unpacklo_ps(a, b);                                                   \
+    hi = _mm256_unpackhi_ps(a, b);                                                   \
+  } else if (s == 2) {                                                               \
+    lo = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(a), _mm256_castps_pd(b))); \
+    hi = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(a), _mm256_castps_pd(b))); \
+  } else {                                                                           \
+    lo = a;                                                                          \
+    hi = b;                                                                          \
+  }                                                                                  \
+  _mm256_store_ps(&out[2 * j], _mm256_permute2f128_ps(lo, hi, 0x20));                \
+  _mm256_store_ps(&out[2 * j + 8], _mm256_permute2f128_ps(lo, hi, 0x31));
+    AVX2_INTERLEAVE(sr, tr, yr)
+    AVX2_INTERLEAVE(si, ti, yi)
+#undef AVX2_INTERLEAVE
+  }
 }
 
-void jum_deinitFFT(jum_FFTSetup* setup) {
-  if (setup != NULL) {
-    deinitPFFFT(&setup->pffft);
+__attribute__((target("avx2,fma"))) void avx2Transform(void* setup, const float* in, float* out,
+                                                       float* work) {
+  const SimdFFT* f = (const SimdFFT*)setup;
+  ma_int32 m = f->m;
+  ma_int32 k, stage, s;
+  float *xr, *xi, *yr, *yi, *tmp;
+  __m256 v0, v1, ar, ai, br, bi, er, ei, or_, oi, wr, wi, xr8, xi8, half;
+  __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  // pick starting buffer so the last stage lands in work, leaving out free for the final split
+  if (f->stages % 2 == 0) {
+    xr = work;
+    yr = out;
+  } else {
+    xr = out;
+    yr = work;
+  }
+  xi = xr + m;
+  yi = yr + m;
+
+  // deinterleave even/odd samples into re/im
+  for (k = 0; k < m; k += 8) {
+    v0 = _mm256_load_ps(&in[2 * k]);
+    v1 = _mm256_load_ps(&in[2 * k + 8]);
+    _mm256_store_ps(&xr[k], _mm256_castpd_ps(_mm256_permute4x64_pd(
+                                _mm256_castps_pd(_mm256_shuffle_ps(v0, v1, 0x88)), 0xd8)));
+    _mm256_store_ps(&xi[k], _mm256_castpd_ps(_mm256_permute4x64_pd(
+                                _mm256_castps_pd(_mm256_shuffle_ps(v0, v1, 0xdd)), 0xd8)));
+  }
+
+  for (stage = 0, s = 1; stage < f->stages; stage++, s <<= 1) {
+    avx2Stage(f, stage, s, xr, xi, yr, yi);
+    tmp = xr;
+    xr = yr;
+    yr = tmp;
+    xi = xr + m;
+    yi = yr + m;
+  }
+
+  out[0] = xr[0] + xi[0];
+  out[1] = xr[0] - xi[0];
+  half = _mm256_set1_ps(0.5F);
+  for (k = 1; k + 8 <= m; k += 8) {
+    ar = _mm256_loadu_ps(&xr[k]);
+    ai = _mm256_loadu_ps(&xi[k]);
+    // z[m - k] for each lane, loaded backwards
+    br = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&xr[m - k - 7]), reverse);
+    bi = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&xi[m - k - 7]), reverse);
+    er = _mm256_mul_ps(_mm256_add_ps(ar, br), half);
+    ei = _mm256_mul_ps(_mm256_sub_ps(ai, bi), half);
+    or_ = _mm256_mul_ps(_mm256_add_ps(ai, bi), half);
+    oi = _mm256_mul_ps(_mm256_sub_ps(br, ar), half);
+    wr = _mm256_loadu_ps(&f->post_re[k]);
+    wi = _mm256_loadu_ps(&f->post_im[k]);
+    xr8 = _mm256_add_ps(er, _mm256_fmsub_ps(wr, or_, _mm256_mul_ps(wi, oi)));
+    xi8 = _mm256_add_ps(ei, _mm256_fmadd_ps(wr, oi, _mm256_mul_ps(wi, or_)));
+    v0 = _mm256_unpacklo_ps(xr8, xi8);
+    v1 = _mm256_unpackhi_ps(xr8, xi8);
+    _mm256_storeu_ps(&out[2 * k], _mm256_permute2f128_ps(v0, v1, 0x20));
+    _mm256_storeu_ps(&out[2 * k + 8], _mm256_permute2f128_ps(v0, v1, 0x31));
+  }
+  simdFFTPostScalar(f, xr, xi, out, k);
+}
 
-    free(setup->raw);
-    free(setup->averaged);
-    free(setup->result);
+const FFTBackend jum_avx2_fft_backend = {"avx2", avx2Supported, avx2Create, simdFFTDestroy,
+                                         avx2Transform};
 
-    free(setup->luts.weights);
-    free(setup->luts.freqs);
-    free(setup->luts.hamming);
+bool avx512Supported(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx512f");
+}
 
-    free(setup);
+void* avx512Create(ma_int32 size) {
+  return simdFFTCreate(size, 16);
+}
 
-    setup = NULL;
+// same as avx2Stage, stages with fewer than 16 butterflies per twiddle interleave with a two
+// source permute using indices built in simdFFTCreate
+__attribute__((target("avx512f"))) void avx512Stage(const SimdFFT* f, ma_int32 stage, ma_int32 s,
+                                                    const float* xr, const float* xi, float* yr,
+                                                    float* yi) {
+  ma_int32 half = f->m / 2;
+  ma_int32 j, q, o;
+  __m512 ar, ai, br, bi, sr, si, dr, di, wr, wi, tr, ti;
+  __m512i perm_lo, perm_hi;
+
+  if (s < 16) {
+    perm_lo = _mm512_loadu_si512(&f->perm[stage][0]);
+    perm_hi = _mm512_loadu_si512(&f->perm[stage][16]);
+  }
+  for (j = 0; j < half; j += 16) {
+    ar = _mm512_load_ps(&xr[j]);
+    ai = _mm512_load_ps(&xi[j]);
+    br = _mm512_load_ps(&xr[j + half]);
+    bi = _mm512_load_ps(&xi[j + half]);
+    sr = _mm512_add_ps(ar, br);
+    si = _mm512_add_ps(ai, bi);
+    dr = _mm512_sub_ps(ar, br);
+    di = _mm512_sub_ps(ai, bi);
+    if (s >= 16) {
+      q = j & (s - 1);
+      wr = _mm512_set1_ps(f->tw_re[j - q]);
+      wi = _mm512_set1_ps(f->tw_im[j - q]);
+    } else {
+      wr = _mm512_load_ps(&f->lane_tw_re[stage][j]);
+      wi = _mm512_load_ps(&f->lane_tw_im[stage][j]);
+    }
+    tr = _mm512_fmsub_ps(dr, wr, _mm512_mul_ps(di, wi));
+    ti = _mm512_fmadd_ps(dr, wi, _mm512_mul_ps(di, wr));
+
+    if (s >= 16) {
+      o = 2 * j - q;
+      _mm512_store_ps(&yr[o], sr);
+      _mm512_store_ps(&yi[o], si);
+      _mm512_store_ps(&yr[o + s], tr);
+      _mm512_store_ps(&yi[o + s], ti);
+    } else {
+      _mm512_store_ps(&yr[2 * j], _mm512_permutex2var_ps(sr, perm_lo, tr));
+      _mm512_store_ps(&yr[2 * j + 16], _mm512_permutex2var_ps(sr, perm_hi, tr));
+      _mm512_store_ps(&yi[2 * j], _mm512_permutex2var_ps(si, perm_lo, ti));
+      _mm512_store_ps(&yi[2 * j + 16], _mm512_permutex2var_ps(si, perm_hi, ti));
+    }
   }
 }
 
-void initPFFFT(PFFFTInfo* info, ma_int32 size) {
-  info->sz = size;
-  info->setup = pffft_new_setup(size, PFFFT_REAL);
-  info->in = (float*)pffft_aligned_malloc(size * sizeof(float));
-  info->out = (float*)pffft_aligned_malloc(size * 2 * sizeof(float));
+__attribute__((target("avx512f"))) void avx512Transform(void* setup, const float* in, float* out,
+                                                        float* work) {
+  const SimdFFT* f = (const SimdFFT*)setup;
+  ma_int32 m = f->m;
+  ma_int32 k, stage, s;
+  float *xr, *xi, *yr, *yi, *tmp;
+  __m512 v0, v1, ar, ai, br, bi, er, ei, or_, oi, wr, wi, xr16, xi16, half;
+  // interleave indices are the s == 1 permute, deinterleave picks even/odd across both sources
+  __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+  __m512i odd = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+  __m512i reverse = _mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m512i inter_lo = _mm512_set_epi32(23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0);
+  __m512i inter_hi =
+      _mm512_set_epi32(31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8);
+
+  if (f->stages % 2 == 0) {
+    xr = work;
+    yr = out;
+  } else {
+    xr = out;
+    yr = work;
+  }
+  xi = xr + m;
+  yi = yr + m;
+
+  for (k = 0; k < m; k += 16) {
+    v0 = _mm512_load_ps(&in[2 * k]);
+    v1 = _mm512_load_ps(&in[2 * k + 16]);
+    _mm512_store_ps(&xr[k], _mm512_permutex2var_ps(v0, even, v1));
+    _mm512_store_ps(&xi[k], _mm512_permutex2var_ps(v0, odd, v1));
+  }
+
+  for (stage = 0, s = 1; stage < f->stages; stage++, s <<= 1) {
+    avx512Stage(f, stage, s, xr, xi, yr, yi);
+    tmp = xr;
+    xr = yr;
+    yr = tmp;
+    xi = xr + m;
+    yi = yr + m;
+  }
+
+  out[0] = xr[0] + xi[0];
+  out[1] = xr[0] - xi[0];
+  half = _mm512_set1_ps(0.5F);
+  for (k = 1; k + 16 <= m; k += 16) {
+    ar = _mm512_loadu_ps(&xr[k]);
+    ai = _mm512_loadu_ps(&xi[k]);
+    br = _mm512_permutexvar_ps(reverse, _mm512_loadu_ps(&xr[m - k - 15]));
+    bi = _mm512_permutexvar_ps(reverse, _mm512_loadu_ps(&xi[m - k - 15]));
+    er = _mm512_mul_ps(_mm512_add_ps(ar, br), half);
+    ei = _mm512_mul_ps(_mm512_sub_ps(ai, bi), half);
+    or_ = _mm512_mul_ps(_mm512_add_ps(ai, bi), half);
+    oi = _mm512_mul_ps(_mm512_sub_ps(br, ar), half);
+    wr = _mm512_loadu_ps(&f->post_re[k]);
+    wi = _mm512_loadu_ps(&f->post_im[k]);
+    xr16 = _mm512_add_ps(er, _mm512_fmsub_ps(wr, or_, _mm512_mul_ps(wi, oi)));
+    xi16 = _mm512_add_ps(ei, _mm512_fmadd_ps(wr, oi, _mm512_mul_ps(wi, or_)));
+    _mm512_storeu_ps(&out[2 * k], _mm512_permutex2var_ps(xr16, inter_lo, xi16));
+    _mm512_storeu_ps(&out[2 * k + 16], _mm512_permutex2var_ps(xr16, inter_hi, xi16));
+  }
+  simdFFTPostScalar(f, xr, xi, out, k);
 }
 
-void deinitPFFFT(PFFFTInfo* info) {
-  if (info) {
-    pffft_destroy_setup(info->setup);
-    info->setup = NULL;
-    pffft_aligned_free(info->in);
-    info->in = NULL;
-    pffft_aligned_free(info->out);
-    info->out = NULL;
-  }
-}
+const FFTBackend jum_avx512_fft_backend = {"avx512", avx512Supported, avx512Create,
+                                           simdFFTDestroy, avx512Transform};
+#endif
 
 // build lookup table of weights for each frequency bin
 // must be done after building lookup table of frequency bins
@@ -909,12 +3827,16 @@ float lerpArray(const float array[][2], ma_int32 size, float x) {
   return array[size - 1][1];
 }
 
+// music volume is applied after the fft tap so that it doesn't affect the visualization
 void jum_setMusicVolume(jum_AudioSetup* setup, float volume) {
   if (volume < 0) {
     setup->control.music_volume = 0;
   } else {
     setup->control.music_volume = volume;
   }
+  if (setup->playback_open) {
+    ma_node_set_output_bus_volume(&setup->fft_tap, 0, setup->control.music_volume);
+  }
 }
 
 void jum_setOtherVolume(jum_AudioSetup* setup, float volume) {
@@ -923,6 +3845,14 @@ void jum_setOtherVolume(jum_AudioSetup* setup, float volume) {
   } else {
     setup->control.other_volume = volume;
   }
+  if (setup->playback_open) {
+    ma_sound_group_set_volume(&setup->other_group, setup->control.other_volume);
+  }
+}
+
+// level the duplex input is heard at, doesn't affect the visualization
+void jum_setMonitorVolume(jum_AudioSetup* setup, float volume) {
+  setup->control.monitor_volume = volume < 0 ? 0 : volume;
 }
 
 void jum_pauseSong(jum_AudioSetup* setup) {
@@ -934,8 +3864,8 @@ void jum_pauseSong(jum_AudioSetup* setup) {
     return;
   }
 
-  if (ma_sound_is_playing(&setup->song_file.sound)) {
-    ma_sound_stop(&setup->song_file.sound);
+  if (ma_sound_is_playing(songSound(setup))) {
+    ma_sound_stop(songSound(setup));
   }
 }
 
@@ -948,12 +3878,47 @@ void jum_resumeSong(jum_AudioSetup* setup) {
     return;
   }
 
-  if (ma_sound_at_end(&setup->song_file.sound)) {
-    ma_sound_seek_to_pcm_frame(&setup->song_file.sound, 0);
+  if (ma_sound_at_end(songSound(setup))) {
+    ma_sound_seek_to_pcm_frame(songSound(setup), 0);
+  }
+  ma_sound_start(songSound(setup));
+}
+
+// change storage format of the audio buffer, ma_format_s16 halves its memory at the cost of
+// quantizing to 16 bits. only allowed while no device is open
+ma_int32 jum_setBufferFormat(jum_AudioSetup* setup, ma_format format) {
+  if (format != ma_format_f32 && format != ma_format_s16) {
+    printf("WARNING: unsupported audio buffer format\n");
+    return -1;
+  }
+  if (setup->playback_open || setup->capture_open) {
+    printf("WARNING: attempting to change audio buffer format with device open\n");
+    return -2;
+  }
+  if (format == setup->buffer.format) {
+    return 0;
+  }
+
+  free(setup->buffer.buf);
+  free(setup->buffer.buf_s16);
+  setup->buffer.buf = NULL;
+  setup->buffer.buf_s16 = NULL;
+  if (format == ma_format_s16) {
+    setup->buffer.buf_s16 = (ma_int16*)malloc(setup->buffer.allocated_sz * sizeof(ma_int16));
+  } else {
+    setup->buffer.buf = (float*)malloc(setup->buffer.allocated_sz * sizeof(float));
   }
-  ma_sound_start(&setup->song_file.sound);
+  setup->buffer.format = format;
+  clearAudioBuffer(&setup->buffer);
+
+  return 0;
 }
 
 void jum_setFFTMode(jum_AudioSetup* setup, jum_AudioMode mode) {
   setup->mode = mode;
+  // music group is only pulled through the fft tap while in playback mode
+  if (setup->playback_open) {
+    ma_node_set_state(&setup->fft_tap, mode == AUDIO_MODE_PLAYBACK ? ma_node_state_started
+                                                                   : ma_node_state_stopped);
+  }
 }
\ No newline at end of file
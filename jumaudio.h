@@ -8,7 +8,6 @@ extern "C" {
 #endif
 
 #include <pthread.h>
-#include <semaphore.h>
 #include <stdbool.h>
 
 #include "miniaudio/miniaudio.h"
@@ -18,8 +17,12 @@ extern "C" {
 
 // 1500 samples (~35ms)
 #define MAX_DESYNC 1500
-#define MAX_SOUND_FILES 32
+#define MAX_SOUND_FILES 256
 #define SOUND_FLAGS (MA_SOUND_FLAG_DECODE | MA_SOUND_FLAG_ASYNC)
+#define SOUND_SOURCE_FLAGS \
+  (MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_DECODE | MA_RESOURCE_MANAGER_DATA_SOURCE_FLAG_ASYNC)
+// alignment of every array in a jum_FFTSetup arena, and of memory passed to jum_initFFTInPlace
+#define JUM_ALIGNMENT 64
 // read only after setup
 typedef struct audioInfo {
   ma_uint32 sample_rate;
@@ -29,55 +32,241 @@ typedef struct audioInfo {
   ma_uint32 period;
 } AudioInfo;
 
-// read/write for init and audio stream callback, read only for everything else
-// all accesses after intialization should acquire mutex
+// writer_pos is only touched by whichever thread writes the audio buffer. the reader position is
+// published along with a count of publishes in a single 64 bit word, so any number of analyzers
+// can each notice new data by comparing the count against the last one they saw, without locking
 typedef struct audioControl {
-  sem_t mutex;
   ma_int32 writer_pos;
-  ma_int32 reader_pos;
-  bool new_data_flag;
-  float music_volume;
-  float other_volume;
+  ma_uint64 published;  // publish count << 32 | reader_pos, only accessed atomically
+  float music_volume;  // applied to music group output, kept so it survives device changes
+  float other_volume;  // applied to other group, kept so it survives device changes
+  float monitor_volume;  // input passed through to the output in duplex mode
 } AudioControl;
 
 typedef struct audioBuffer {
   // lock free, single producer, single consumer circular buffer
-  float* buf;
-  ma_int32 sz;
-  ma_int32 allocated_sz;
+  float* buf;          // samples when format is ma_format_f32, otherwise NULL
+  ma_int16* buf_s16;   // samples when format is ma_format_s16, otherwise NULL
+  ma_format format;    // storage format, samples are always written and read as f32
+  ma_int32 sz;         // in samples
+  ma_int32 allocated_sz;  // in samples
 } AudioBuffer;
 
+#define METER_CHANNELS 2
+#define METER_BLOCK_MS 100           // loudness is accumulated in blocks of this length
+#define METER_MOMENTARY_BLOCKS 4     // 400ms momentary loudness window
+#define METER_SHORT_TERM_BLOCKS 30   // 3s short term loudness window
+#define TRUE_PEAK_OVERSAMPLE 4
+#define TRUE_PEAK_TAPS 12  // taps per polyphase branch of the true peak interpolator
+
+// levels of the signal being analyzed, copied out by jum_getMeter
+typedef struct jum_meter_snapshot {
+  float rms[METER_CHANNELS];        // running rms per channel (~300ms time constant), linear
+  float peak[METER_CHANNELS];       // sample peak per channel with slow release, linear
+  float true_peak[METER_CHANNELS];  // 4x oversampled peak per channel with slow release, linear
+  float momentary;                  // K-weighted loudness over last 400ms, LUFS
+  float short_term;                 // K-weighted loudness over last 3s, LUFS
+} jum_MeterSnapshot;
+
+typedef struct biquad {
+  float b0, b1, b2, a1, a2;
+} Biquad;
+
+// updated incrementally by the audio callback over only the new samples of each block,
+// snapshot is published with a sequence counter so reading it never blocks the callback
+typedef struct meter {
+  Biquad shelf;     // K-weighting stage 1, head related high shelf
+  Biquad highpass;  // K-weighting stage 2, RLB high pass
+  float shelf_state[METER_CHANNELS][2];
+  float highpass_state[METER_CHANNELS][2];
+  float tp_coeffs[TRUE_PEAK_OVERSAMPLE][TRUE_PEAK_TAPS];
+  float tp_history[METER_CHANNELS][TRUE_PEAK_TAPS];
+  float rms_coeff;     // per sample coefficient for running mean square
+  float release;       // per sample multiplier applied to held peaks
+  float mean_square[METER_CHANNELS];
+  float peak[METER_CHANNELS];
+  float true_peak[METER_CHANNELS];
+  float block_energy;  // K-weighted energy of current block, summed over channels
+  ma_uint32 block_len;
+  ma_uint32 block_pos;
+  float blocks[METER_SHORT_TERM_BLOCKS];  // mean square of each completed block, circular
+  ma_uint32 block_index;
+  ma_uint32 seq;  // odd while snapshot is being written
+  ma_uint32 pending_rate;  // reset requested at this sample rate, only accessed atomically
+  jum_MeterSnapshot snapshot;
+} Meter;
+
 typedef enum {
   AUDIO_MODE_NONE,
   AUDIO_MODE_PLAYBACK,
   AUDIO_MODE_CAPTURE,
+  AUDIO_MODE_DUPLEX,  // analyze input of a duplex device and pass it through to the output
+  AUDIO_MODE_PUSH,    // analyze samples given to jum_pushSamples, no device needed
 } jum_AudioMode;
 
+// called on a resource manager job thread when a sound finishes loading, status is what
+// jum_getSoundStatus would return for the handle
+typedef void (*jum_SoundLoaded)(ma_int32 handle, ma_int32 status, void* user_data);
+
+// done notification for one sound, miniaudio signals it through the callbacks
+typedef struct sound_load {
+  ma_async_notification_callbacks callbacks;  // must be first
+  struct jum_audio* setup;
+  ma_int32 handle;
+} SoundLoad;
+
 // absolute filepath along with its associated ma_audio sound
 typedef struct sound_file {
   char* filepath;
-  ma_sound sound;
+  ma_sound sound;                          // only initialized while the playback device is open
+  ma_resource_manager_data_source source;  // holds the decoded buffer from when it's queued
+  SoundLoad load;
 } SoundFile;
 
+#define SEEK_POINTS 1024  // seek table entries built for each song, for formats without their own
+#define SONG_STREAM_FLAGS (MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC)
+enum { SEEKER_NONE, SEEKER_BUILDING, SEEKER_READY };
+enum { PRIME_IDLE, PRIME_READY, PRIME_APPLYING };
+
+// audio from a jum_seekSong target, written by the fft tap over what was already predecoded so
+// the output and analysis both jump straight to the target
+typedef struct seek_prime {
+  float* buf;          // (predecode_bufs + 1) * period frames starting at the target
+  ma_uint32 frames;
+  ma_uint64 target;    // frame at the engine's sample rate
+  ma_sound* sound;     // sound that continues after the primed frames
+  ma_uint32 src_rate;  // sample rate of the sound's cursor
+  ma_int32 state;      // PRIME_IDLE/READY/APPLYING, only accessed atomically
+} SeekPrime;
+
+#define WAVEFORM_BASE 256    // frames summarized by each entry of the finest overview level
+#define WAVEFORM_LEVELS 24   // each level halves the one below, enough for any song length
+#define WAVEFORM_CHUNK 4096  // frames read from the decoded song at a time
+
+// one column of a waveform overview, of the mono mix
+typedef struct jum_waveform_peak {
+  float min;
+  float max;
+  float rms;
+} jum_WaveformPeak;
+
+// min/max/rms pyramid of the song, entries of level n each cover WAVEFORM_BASE << n frames. built
+// from the song's decoded buffer as the background decode fills it in, so nothing is decoded twice.
+// about 2 * 12 bytes per WAVEFORM_BASE frames, ~1% of the decoded audio
+typedef struct waveform {
+  ma_resource_manager_data_source source;  // shares the song's decoded data, with its own cursor
+  bool open;
+  bool finished;                           // whole song has been summarized
+  jum_WaveformPeak* levels[WAVEFORM_LEVELS];  // rms holds the mean square until queried
+  ma_uint64 counts[WAVEFORM_LEVELS];
+  ma_uint64 capacity[WAVEFORM_LEVELS];
+  jum_WaveformPeak pending;  // level 0 entry still being accumulated
+  ma_uint32 pending_frames;
+  ma_uint64 summarized;      // frames read so far
+  ma_uint64 total_frames;    // length of the song, 0 if not known yet
+} Waveform;
+
+// node sitting between the music group and the engine endpoint, copies everything passing through
+// into the audio buffer for fft and outputs it again predecode_bufs periods later
+typedef struct fft_tap_node {
+  ma_node_base base;
+  struct jum_audio* setup;
+} FFTTapNode;
+
+#define RECORD_RING_FRAMES (1 << 18)  // ~5s staging at 48kHz, must be a power of 2
+#define RECORD_BATCH_FRAMES 16384     // written to disk at a time, keeps O_DIRECT writes aligned
+#define RECORD_POLL_MS 10             // writer thread sleep between checks of the ring
+#define RECORD_PREALLOC_BYTES (64 << 20)  // raw files are extended this much at a time
+#define RECORD_DIRECT_ALIGN 4096  // O_DIRECT buffer, offset and size alignment
+enum { RECORD_IDLE, RECORD_ACTIVE, RECORD_APPENDING };
+
+typedef enum {
+  JUM_RECORD_WAV,         // 32 bit float wav through ma_encoder
+  JUM_RECORD_RAW,         // headerless interleaved f32
+  JUM_RECORD_RAW_DIRECT,  // raw with O_DIRECT, bypassing the page cache
+} jum_RecordFormat;
+
+typedef struct jum_recording_status {
+  bool recording;
+  ma_uint64 frames_written;  // made it to disk
+  ma_uint64 frames_dropped;  // didn't fit in the staging ring
+} jum_RecordingStatus;
+
+// the audio callback only appends to the staging ring, a writer thread moves it to disk in batches
+typedef struct recorder {
+  float* ring;   // RECORD_RING_FRAMES frames
+  float* batch;  // RECORD_BATCH_FRAMES frames, page aligned for O_DIRECT
+  ma_uint32 channels;
+  ma_uint64 write_count;  // frames appended by the audio thread, only accessed atomically
+  ma_uint64 read_count;   // frames taken by the writer thread, only accessed atomically
+  ma_uint64 dropped;      // only accessed atomically
+  ma_uint64 written;      // only accessed atomically
+  ma_int32 state;         // RECORD_IDLE/ACTIVE/APPENDING, only accessed atomically
+  bool stop;              // tells the writer thread to drain and exit, only accessed atomically
+  jum_RecordFormat format;
+  ma_encoder encoder;   // wav
+  int fd;               // raw
+  ma_uint64 allocated;  // bytes preallocated in the raw file
+  bool failed;          // a write failed, later batches are dropped instead of written
+  pthread_t thread;
+} Recorder;
+
+#ifdef JUMAUDIO_TRACE
+#define TRACE_EVENTS 16384  // per thread, oldest events are overwritten
+#define TRACE_THREADS 16    // threads past this many aren't recorded
+
+// one traced scope, written to chrome trace json as a complete event
+typedef struct trace_event {
+  const char* name;
+  ma_uint64 start_ns;
+  ma_uint64 end_ns;
+} TraceEvent;
+
+// only written by the thread that claimed it, head is published after each event is filled in
+typedef struct trace_ring {
+  TraceEvent events[TRACE_EVENTS];
+  ma_uint64 head;  // total events written, only accessed atomically
+} TraceRing;
+
+typedef struct trace_scope {
+  const char* name;
+  ma_uint64 start_ns;
+} TraceScope;
+#endif
+
 // audio player/capturer setup
 typedef struct jum_audio {
   AudioBuffer buffer;
   AudioControl control;
   AudioInfo info;
 
-  float* conversion_buf;
-  ma_uint32 conversion_sz;
   ma_int32 predecode_bufs;
 
   ma_context context;
   ma_resource_manager resource_manager;
 
-  ma_engine music_engine;  // sounds played from this engine will have FFT performed
-  SoundFile song_file;     // the single sound playing on the music engine
+  ma_engine engine;            // single engine mixing both groups into the playback device
+  ma_sound_group music_group;  // sounds played in this group will have FFT performed
+  FFTTapNode fft_tap;          // music group -> fft_tap -> endpoint
+  SoundFile song_file;         // the single sound playing in the music group
+  ma_decoder song_seeker;      // song opened again with a seek index, used by jum_seekSong
+  ma_int32 seeker_state;       // SEEKER_NONE/BUILDING/READY, only accessed atomically
+  pthread_t seeker_thread;     // builds the seek index without holding up jum_playSong
+  bool seeker_thread_open;
+  ma_sound song_stream;        // streams the song after seeking past the decode so far
+  bool song_streaming;
+  SeekPrime prime;
+  Waveform waveform;  // overview of the current song
+  Recorder recorder;  // what is captured or played, written to disk
 
-  ma_engine other_engine;  // sounds played from this engine will not contribute to FFT
+  ma_sound_group other_group;  // sounds played in this group will not contribute to FFT
   SoundFile sound_files[MAX_SOUND_FILES];
   ma_int32 num_sound_files;
+  ma_fence load_fence;  // held by every sound still decoding
+  jum_SoundLoaded sound_loaded;
+  void* sound_loaded_data;
+
+  ma_int64 push_next_frame;  // timestamp expected for the next pushed frame, -1 if unknown
 
   ma_device playback_device;
   bool playback_open;
@@ -85,18 +274,33 @@ typedef struct jum_audio {
   bool capture_open;
 
   jum_AudioMode mode;
+  Meter meter;  // levels of the audio written to the audio buffer
 
+  // snapshot of available devices, empty until jum_getDevices is called
   ma_device_info* playback_device_info;
   ma_device_info* capture_device_info;
   ma_uint32 playback_device_count, capture_device_count;
+  bool devices_enumerated;
+  bool devices_stale;  // set from device notifications, re-enumerate on next jum_getDevices
 } jum_AudioSetup;
 
-// pffft data
+// real forward fft implementation, output is ordered the same as pffft_transform_ordered
+typedef struct fft_backend {
+  const char* name;
+  bool (*supported)(void);         // checked at runtime against the cpu
+  void* (*create)(ma_int32 size);  // NULL if size isn't supported
+  void (*destroy)(void* setup);
+  void (*transform)(void* setup, const float* in, float* out, float* work);
+} FFTBackend;
+
+// fft data
 typedef struct pffftinfo {
   ma_int32 sz;
   float* in;
   float* out;
-  PFFFT_Setup* setup;
+  float* work;  // scratch, fft_sz floats
+  void* setup;
+  const FFTBackend* backend;
 } PFFFTInfo;
 
 typedef struct fft_tables {
@@ -105,40 +309,242 @@ typedef struct fft_tables {
   float* hamming;  // constants to multiple input by for hamming window
 } FFTTables;
 
+// fft setup and lookup tables, read only once built and shared between every jum_FFTSetup
+// created with the same configuration, the tables don't depend on sample rate
+typedef struct fft_plan {
+  ma_int32 fft_sz;
+  ma_int32 num_bins;
+  float (*freq_points)[2];  // copy of configuration used as cache key
+  ma_int32 freqs_sz;
+  float (*weight_points)[2];  // copy of configuration used as cache key
+  ma_int32 weights_sz;
+  void* setup;  // created by backend
+  const FFTBackend* backend;
+  FFTTables luts;
+  ma_int32 refcount;  // guarded by plan cache mutex
+  struct fft_plan* next;
+} FFTPlan;
+
+#define ONSET_BANDS 4             // bins are split into this many equal bands for onset detection
+#define ONSET_THRESHOLD 1.5F      // standard deviations above mean flux to count as an onset
+#define ONSET_MIN_INTERVAL 100    // ms, minimum time between onsets
+#define ONSET_STATS_MS 1000       // ms, time constant of running flux mean/variance
+#define ONSET_ENV_RATE 100        // Hz, onset strength is resampled to this rate for tempo
+#define ONSET_ENV_SIZE 128        // onset strength history, must exceed longest tempo lag
+#define TEMPO_MIN_BPM 60
+#define TEMPO_MAX_BPM 180
+#define TEMPO_MIN_LAG (ONSET_ENV_RATE * 60 / TEMPO_MAX_BPM)
+#define TEMPO_MAX_LAG (ONSET_ENV_RATE * 60 / TEMPO_MIN_BPM)
+#define TEMPO_LAGS (TEMPO_MAX_LAG - TEMPO_MIN_LAG + 1)
+#define TEMPO_MEMORY_MS 4000  // ms, time constant of tempo autocorrelation
+
+// state for spectral flux onset detection and tempo tracking, updated each jum_analyze call
+// from the weighted spectrum so no extra transforms are needed
+typedef struct onset_tracker {
+  float* prev;                  // previous weighted spectrum, num_bins size
+  float mean[ONSET_BANDS];      // running mean of flux per band
+  float var[ONSET_BANDS];       // running variance of flux per band
+  float mean_total;             // running mean of flux over all bands
+  float since_onset;            // ms since last onset in any band
+  float env[ONSET_ENV_SIZE];    // onset strength at ONSET_ENV_RATE, circular
+  ma_int32 env_pos;
+  float env_peak;               // strongest onset since last env sample
+  float env_time;               // ms accumulated toward next env sample
+  float acf[TEMPO_LAGS];        // leaky autocorrelation of env for each tempo lag
+  float prior[TEMPO_LAGS];      // weighting towards common tempos to avoid octave errors
+} OnsetTracker;
+
+typedef enum {
+  JUM_OUTPUT_F32,
+  JUM_OUTPUT_F16,  // IEEE half float
+  JUM_OUTPUT_U16,  // rounded and clamped to 0-65535
+  JUM_OUTPUT_U8,   // rounded and clamped to 0-255
+} jum_OutputType;
+
+// caller owned buffer written by the final stage of jum_analyze, e.g. a mapped GPU buffer.
+// element i is written at dst + i * stride bytes with value result[i] * scale + offset
+typedef struct output_target {
+  void* dst;  // NULL when no target is set
+  size_t stride;
+  jum_OutputType type;
+  float scale;
+  float offset;
+} OutputTarget;
+
+// last num_rows results kept for waterfall/spectrogram displays, row-major with num_bins elements
+// per row. rows after head are older, so oldest to newest is at most two contiguous spans
+typedef struct history {
+  void* rows;  // NULL when disabled
+  size_t row_sz;  // bytes per row
+  ma_int32 num_rows;
+  ma_int32 head;        // most recently written row
+  ma_int32 filled;      // rows written so far, up to num_rows
+  ma_int32 decimation;  // one row is kept for every decimation jum_analyze calls
+  ma_int32 skipped;
+  jum_OutputType type;
+  float scale;  // integer types are scaled to fill their range
+} History;
+
+// skips the transform while the analysis window holds nothing above threshold
+typedef struct silence_gate {
+  float threshold;       // linear peak, 0 only gates digital silence
+  ma_int32 quiet_run;    // samples at the end of the window since one above threshold
+  ma_int32 last_end;     // end of the analysis window on the previous call, -1 to rescan
+  bool gated;            // transform was skipped on the last call
+  bool settled;          // output has decayed to the silent floor and is no longer updated
+} SilenceGate;
+
+// quality levels stepped through when jum_analyze runs over its time budget, each level keeps
+// the reductions of the ones before it
+typedef enum {
+  JUM_QUALITY_FULL,
+  JUM_QUALITY_REDUCED_SMOOTHING,  // smooth across fewer neighbouring bins
+  JUM_QUALITY_HALF_FFT,           // transform fft_sz/2 samples
+  JUM_QUALITY_QUARTER_FFT,        // transform fft_sz/4 samples
+  JUM_QUALITY_SKIP_FRAMES,        // only analyze every other call, reusing the previous result
+} jum_Quality;
+
+#define QUALITY_STAGES 3         // window + transform, binning + weighting + onsets, smoothing + output
+#define QUALITY_DEGRADE_FRAMES 3   // consecutive frames over budget before dropping a level
+#define QUALITY_RECOVER_FRAMES 60  // consecutive frames under half budget before raising a level
+
+typedef struct quality_control {
+  float budget_ms;  // 0 disables adaptation
+  jum_Quality level;
+  float stage_ms[QUALITY_STAGES];  // running average cost of each stage at the current level
+  float total_ms;                  // running average cost of a whole call
+  FFTPlan* reduced_plans[2];       // plans for fft_sz/2 and fft_sz/4, NULL if size unsupported
+  ma_int32 over_count;
+  ma_int32 under_count;
+  bool skip_next;
+  ma_uint32 skipped_ms;  // time covered by skipped calls, handed to the next analyzed frame
+} QualityControl;
+
+// extra set of output bins fed from the same transform as the jum_FFTSetup it's added to, only
+// the binning, weighting, averaging and smoothing are done per layout
+typedef struct jum_fft_layout {
+  ma_int32 num_bins;
+  float* freqs;     // frequencies for each bin
+  float* weights;   // weights applied for each frequency bin
+  float* raw;       // num_bins size
+  float* averaged;  // num_bins size
+  float* result;    // normalized 0-1 output, num_bins size
+  float max;
+  struct jum_fft_layout* next;
+} jum_FFTLayout;
+
 typedef struct jum_fft {
-  PFFFTInfo pffft;    // pffft setup and inout buffers
+  PFFFTInfo pffft;    // fft setup (owned by plan) and inout buffers
+  FFTPlan* plan;      // shared plan this setup was created from
+  FFTPlan* pending_plan;  // tables submitted by jum_swapTables, picked up by next jum_analyze
+  FFTPlan* retired_plan;  // replaced plan, released by the next jum_swapTables or deinit
   ma_int32 num_bins;  // number of output frequncy bins
+  ma_int32 max_bins;  // num_bins the arena was laid out for
   float* raw;         // raw fft output, num_bins size
   float* averaged;    // fft with averaging over time, num_bins size
   float* result;      // final fft with averaging and weighting, num_bins size
-  FFTTables luts;     // lookup tables generated on init
+  float* magnitudes;  // magnitude of each fft bin, fft_sz/2 size, shared by all layouts
+  jum_FFTLayout* layouts;  // extra outputs added with jum_addLayout
+  FFTTables luts;     // lookup tables, owned by plan
   float max;          // max result ever output, keep track for normalizing output
   ma_int32 pos;       // last pos in audio buffer used for fft
+  ma_uint32 last_publish;  // publish count of the last reader position seen
+  float delay_ms;          // extra delay behind the reader position
   float level;        // average audio level of the audio buffer
+  float flux[ONSET_BANDS];  // spectral flux of each band for the last frame
+  ma_uint32 onset;    // bitmask of bands with an onset in the last frame, 0 if none
+  float bpm;          // current tempo estimate, 0 until enough history
+  float beat_phase;   // position within the current beat, 0-1
+  bool beat;          // beat occurred during last frame
+  OnsetTracker onset_state;
+  OutputTarget output;  // optional extra destination for result
+  History history;      // optional history of past results
+  SilenceGate gate;
+  QualityControl quality;
+  bool owns_memory;   // arena was allocated by jum_initFFT rather than provided by caller
 } jum_FFTSetup;
 
 jum_AudioSetup* jum_initAudio(ma_uint32 buffer_size, ma_uint32 predecode_bufs, ma_uint32 period);
 void jum_deinitAudio(jum_AudioSetup* setup);
 ma_int32 jum_openPlaybackDevice(jum_AudioSetup* setup, ma_int32 device_index);
 ma_int32 jum_openCaptureDevice(jum_AudioSetup* setup, ma_int32 device_index);
+ma_int32 jum_openDuplexDevice(jum_AudioSetup* setup, ma_int32 playback_index,
+                              ma_int32 capture_index);
+ma_int32 jum_getDevices(jum_AudioSetup* setup, bool refresh);
+void jum_openPushInput(jum_AudioSetup* setup, ma_uint32 sample_rate);
+ma_int32 jum_pushSamples(jum_AudioSetup* setup, const void* frames, ma_uint32 count,
+                         ma_format format, ma_uint32 channels, ma_int64 timestamp);
+ma_int32 jum_reserveSamples(jum_AudioSetup* setup, ma_uint32 count, float** first,
+                            ma_uint32* first_frames, float** second, ma_uint32* second_frames);
+ma_int32 jum_commitSamples(jum_AudioSetup* setup, ma_uint32 count);
 void jum_printAudioInfo(AudioInfo info);
 void jum_analyze(jum_FFTSetup* fft, jum_AudioSetup* audio, ma_uint32 msec);
+ma_int32 jum_windowPosition(const jum_AudioSetup* audio, ma_int32* pos, ma_uint32* last_publish,
+                            ma_uint32 msec, ma_int32 window_sz, float delay_ms);
 jum_FFTSetup* jum_initFFT(const float freq_points[][2], ma_int32 freqs_sz,
                           const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
                           ma_int32 num_bins);
+size_t jum_FFTSetupSize(ma_int32 fft_sz, ma_int32 num_bins);
+jum_FFTSetup* jum_initFFTInPlace(void* mem, size_t mem_sz, const float freq_points[][2],
+                                 ma_int32 freqs_sz, const float weight_points[][2],
+                                 ma_int32 weights_sz, ma_int32 fft_sz, ma_int32 num_bins);
 void jum_deinitFFT(jum_FFTSetup* setup);
+void jum_setOutputTarget(jum_FFTSetup* setup, void* dst, size_t stride, jum_OutputType type,
+                         float scale, float offset);
+void jum_setSilenceThreshold(jum_FFTSetup* setup, float threshold);
+void jum_setTimeBudget(jum_FFTSetup* setup, float budget_ms);
+void jum_setAnalysisDelay(jum_FFTSetup* setup, float delay_ms);
+FFTPlan* jum_acquireFFTPlan(const float freq_points[][2], ma_int32 freqs_sz,
+                            const float weight_points[][2], ma_int32 weights_sz, ma_int32 fft_sz,
+                            ma_int32 num_bins);
+void jum_releaseFFTPlan(FFTPlan* plan);
+ma_int32 jum_swapTables(jum_FFTSetup* setup, const float freq_points[][2], ma_int32 freqs_sz,
+                        const float weight_points[][2], ma_int32 weights_sz, ma_int32 num_bins);
+jum_FFTLayout* jum_addLayout(jum_FFTSetup* setup, const float freq_points[][2], ma_int32 freqs_sz,
+                             const float weight_points[][2], ma_int32 weights_sz,
+                             ma_int32 num_bins);
+void jum_removeLayout(jum_FFTSetup* setup, jum_FFTLayout* layout);
+ma_int32 jum_enableHistory(jum_FFTSetup* setup, ma_int32 num_rows, ma_int32 decimation,
+                           jum_OutputType type);
+ma_int32 jum_getHistory(jum_FFTSetup* setup, const void** first, ma_int32* first_rows,
+                        const void** second, ma_int32* second_rows);
+const char* jum_getFFTBackendName(jum_FFTSetup* setup);
 void jum_setMusicVolume(jum_AudioSetup* setup, float volume);
 void jum_setOtherVolume(jum_AudioSetup* setup, float volume);
+void jum_setMonitorVolume(jum_AudioSetup* setup, float volume);
 ma_int32 jum_playSong(jum_AudioSetup* setup, const char* filepath);
 float jum_getSongCursor(jum_AudioSetup* setup);
 float jum_getSongLength(jum_AudioSetup* setup);
 bool jum_isSongFinished(jum_AudioSetup* setup);
+ma_int32 jum_seekSong(jum_AudioSetup* setup, float seconds);
+ma_int32 jum_getWaveform(jum_AudioSetup* setup, ma_int32 width, jum_WaveformPeak* peaks);
 void jum_pauseSong(jum_AudioSetup* setup);
 void jum_resumeSong(jum_AudioSetup* setup);
 ma_int32 jum_loadSound(jum_AudioSetup* setup, const char* filepath);
+ma_int32 jum_loadSounds(jum_AudioSetup* setup, const char* const* paths, ma_int32 count,
+                        ma_int32* handles);
+ma_int32 jum_getSoundStatus(jum_AudioSetup* setup, ma_int32 handle);
+void jum_waitForSounds(jum_AudioSetup* setup);
+void jum_setSoundLoadedCallback(jum_AudioSetup* setup, jum_SoundLoaded callback, void* user_data);
+ma_int32 jum_setLoadThreads(jum_AudioSetup* setup, ma_uint32 count);
 ma_int32 jum_playSound(jum_AudioSetup* setup, ma_int32 handle, float repeat_delay);
 void jum_clearSoundFiles(jum_AudioSetup* setup);
 void jum_setFFTMode(jum_AudioSetup* setup, jum_AudioMode mode);
+ma_int32 jum_setBufferFormat(jum_AudioSetup* setup, ma_format format);
+void jum_getMeter(jum_AudioSetup* setup, jum_MeterSnapshot* snapshot);
+ma_int32 jum_dumpTrace(const char* filepath);
+ma_int32 jum_startRecording(jum_AudioSetup* setup, const char* filepath, jum_RecordFormat format);
+ma_int32 jum_stopRecording(jum_AudioSetup* setup);
+void jum_getRecordingStatus(jum_AudioSetup* setup, jum_RecordingStatus* status);
+
+// fft backends in order of preference, plans use the first one the cpu and size support
+extern const FFTBackend jum_pffft_backend;
+#if defined(__x86_64__) || defined(__i386__)
+extern const FFTBackend jum_avx2_fft_backend;
+extern const FFTBackend jum_avx512_fft_backend;
+#endif
+extern const FFTBackend* const jum_fft_backends[];
+extern const ma_int32 jum_num_fft_backends;
 
 #ifdef __cplusplus
 }
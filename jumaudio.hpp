@@ -0,0 +1,271 @@
+/* Copyright (c) 2022  Hunter Whyte */
+
+#ifndef JUMAUDIO_HPP_
+#define JUMAUDIO_HPP_
+
+// header only C++17 layer over jumaudio. Analyzer runs the core analysis pipeline (window,
+// transform, binning, weighting, averaging, smoothing, normalizing) with the fft size, bin count
+// and channel count fixed at compile time, so every stage loop has constant bounds and no channel
+// branches, and all working buffers live inside the object. only the C core's shared plan (tables
+// and fft backend) is held, no jum_FFTSetup arena. silence gating, onsets, quality levels, layouts
+// and history are only in the C path
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "jumaudio.h"
+
+namespace jum {
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+template <class T, std::size_t N>
+using Span = std::span<T, N>;
+#else
+// fixed size view for C++17, same interface as the parts of std::span used here
+template <class T, std::size_t N>
+class Span {
+ public:
+  constexpr Span(T* data, std::size_t) : data_(data) {}
+  constexpr T* data() const { return data_; }
+  constexpr std::size_t size() const { return N; }
+  constexpr T& operator[](std::size_t i) const { return data_[i]; }
+  constexpr T* begin() const { return data_; }
+  constexpr T* end() const { return data_ + N; }
+
+ private:
+  T* data_;
+};
+#endif
+
+// matches SMOOTHING_SPREAD in jumaudio.c
+constexpr int kSmoothingSpread = 7;
+
+// bins each side applySmoothing averages over, only depends on the bin index
+template <int NumBins>
+constexpr std::array<int, NumBins> smoothingWidths() {
+  std::array<int, NumBins> widths{};
+  for (int i = 0; i < NumBins; i++) {
+    float x = ((float)NumBins - (float)i) / ((float)NumBins);
+    widths[i] = (int)(x * kSmoothingSpread) + 2;
+  }
+  return widths;
+}
+
+template <int FftSize, int NumBins, int Channels>
+class Analyzer {
+  static_assert(FftSize > 0 && (FftSize & (FftSize - 1)) == 0, "FftSize must be a power of 2");
+  static_assert(NumBins > 0 && NumBins <= FftSize / 2, "NumBins must fit in the spectrum");
+  static_assert(Channels == 1 || Channels == 2, "audio buffer holds 1 or 2 channels");
+
+ public:
+  template <std::size_t NumFreqs, std::size_t NumWeights>
+  Analyzer(const float (&freq_points)[NumFreqs][2], const float (&weight_points)[NumWeights][2])
+      : plan_(jum_acquireFFTPlan(freq_points, NumFreqs, weight_points, NumWeights, FftSize,
+                                 NumBins)) {
+    result_.fill(0);
+    averaged_.fill(0);
+    raw_.fill(0);
+  }
+  ~Analyzer() { jum_releaseFFTPlan(plan_); }
+
+  Analyzer(const Analyzer&) = delete;
+  Analyzer& operator=(const Analyzer&) = delete;
+  Analyzer(Analyzer&& other) noexcept { *this = std::move(other); }
+  Analyzer& operator=(Analyzer&& other) noexcept {
+    if (this != &other) {
+      jum_releaseFFTPlan(plan_);
+      plan_ = std::exchange(other.plan_, nullptr);
+      bin_ranges_ready_ = other.bin_ranges_ready_;
+      sample_rate_ = other.sample_rate_;
+      bin_ranges_ = other.bin_ranges_;
+      raw_ = other.raw_;
+      averaged_ = other.averaged_;
+      result_ = other.result_;
+      max_ = other.max_;
+      pos_ = other.pos_;
+      last_publish_ = other.last_publish_;
+      delay_ms_ = other.delay_ms_;
+    }
+    return *this;
+  }
+
+  // false if the fft plan couldn't be created
+  explicit operator bool() const { return plan_ != nullptr; }
+
+  // same as jum_setAnalysisDelay
+  void setAnalysisDelay(float delay_ms) { delay_ms_ = delay_ms < 0 ? 0 : delay_ms; }
+
+  // same as jum_analyze. false if audio isn't a 32 bit float buffer with Channels channels
+  bool analyze(jum_AudioSetup& audio, ma_uint32 msec) {
+    if (plan_ == nullptr || audio.buffer.format != ma_format_f32 ||
+        audio.info.channels != (ma_uint32)Channels) {
+      return false;
+    }
+    if (!bin_ranges_ready_ || sample_rate_ != audio.info.sample_rate) {
+      buildBinRanges(audio.info.sample_rate);
+    }
+
+    window(audio.buffer.buf,
+           jum_windowPosition(&audio, &pos_, &last_publish_, msec, FftSize, delay_ms_),
+           audio.buffer.sz);
+    plan_->backend->transform(plan_->setup, in_.data(), out_.data(), work_.data());
+    for (int i = 0; i < FftSize / 2; i++) {
+      magnitudes_[i] = sqrtf((out_[i * 2] * out_[i * 2]) + (out_[i * 2 + 1] * out_[i * 2 + 1]));
+    }
+    bin();
+    for (int i = 0; i < NumBins; i++) {
+      raw_[i] = log10f(raw_[i] + 0.5) + 0.31;
+      raw_[i] *= plan_->luts.weights[i];
+    }
+    // jump up quickly, fall down slowly
+    for (int i = 0; i < NumBins; i++) {
+      if (raw_[i] > averaged_[i]) {
+        averaged_[i] = (0.2F) * averaged_[i] + ((1 - 0.2F) * raw_[i]);
+      } else {
+        averaged_[i] = (0.9F) * averaged_[i] + ((1 - 0.9F) * raw_[i]);
+      }
+    }
+    smooth();
+    for (int i = 0; i < NumBins; i++) {
+      max_ = result_[i] > max_ ? result_[i] : max_;
+    }
+    for (int i = 0; i < NumBins; i++) {
+      result_[i] = (result_[i] - 0) / (max_ - 0);
+    }
+    return true;
+  }
+
+  // normalized 0-1 output
+  Span<const float, NumBins> result() const {
+    return Span<const float, NumBins>(result_.data(), NumBins);
+  }
+  // frequency of each bin, from the shared plan
+  Span<const float, NumBins> freqs() const {
+    return Span<const float, NumBins>(plan_->luts.freqs, NumBins);
+  }
+
+ private:
+  // range of fft magnitudes averaged into a bin, bins skipped over copy the bin before them
+  struct BinRange {
+    int start;
+    int count;
+    bool average;  // the last bin reached isn't averaged, same as readIntoBins
+    bool copy;
+    bool touched;
+  };
+
+  // contiguous runs up to the wrap point instead of a modulo per sample
+  void window(const float* samples, ma_int32 pos, ma_int32 size) {
+    const float* hamming = plan_->luts.hamming;
+    int first = (size - pos) / Channels;
+    first = first < FftSize ? first : FftSize;
+    windowRun(samples + pos, hamming, in_.data(), first);
+    windowRun(samples, hamming + first, in_.data() + first, FftSize - first);
+  }
+
+  static void windowRun(const float* samples, const float* hamming, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+      if constexpr (Channels == 2) {
+        out[i] = samples[i * 2] * hamming[i];
+        out[i] += samples[i * 2 + 1] * hamming[i];
+        out[i] /= 2;
+      } else {
+        out[i] = samples[i] * hamming[i];
+      }
+    }
+  }
+
+  // replay readIntoBins once to find which magnitudes land in which bin
+  void buildBinRanges(ma_uint32 sample_rate) {
+    const float* freqs = plan_->luts.freqs;
+    float rate = (float)sample_rate;
+    float freq;
+    int current = 0;
+    int i;
+
+    bin_ranges_.fill(BinRange{0, 0, false, false, false});
+    bin_ranges_[0].touched = true;
+    for (i = 0; i < FftSize / 2; i++) {
+      freq = (i * (rate / 2)) / (FftSize / 2);
+      if (freq > freqs[current]) {
+        bin_ranges_[current].average = true;
+        current++;
+        while (freq > freqs[current]) {
+          if (current >= NumBins) {
+            break;
+          }
+          if (current != 0) {
+            bin_ranges_[current] = BinRange{0, 0, false, true, true};
+          }
+          current++;
+        }
+        if (current >= NumBins) {
+          break;
+        }
+        bin_ranges_[current] = BinRange{i, 0, false, false, true};
+      }
+      bin_ranges_[current].count++;
+    }
+    sample_rate_ = sample_rate;
+    bin_ranges_ready_ = true;
+  }
+
+  void bin() {
+    float sum;
+    for (int b = 0; b < NumBins; b++) {
+      const BinRange& range = bin_ranges_[b];
+      if (!range.touched) {
+        continue;
+      }
+      if (range.copy) {
+        raw_[b] = raw_[b - 1];
+        continue;
+      }
+      sum = 0;
+      for (int i = range.start; i < range.start + range.count; i++) {
+        sum += magnitudes_[i];
+      }
+      raw_[b] = range.average ? sum / range.count : sum;
+    }
+  }
+
+  void smooth() {
+    static constexpr std::array<int, NumBins> widths = smoothingWidths<NumBins>();
+    for (int i = 0; i < NumBins; i++) {
+      for (int j = 0; j < widths[i]; j++) {
+        if (i - j > 0) {
+          result_[i] += averaged_[i - j] / (widths[i] * 2);
+        }
+        if (i + j < NumBins) {
+          result_[i] += averaged_[i + j] / (widths[i] * 2);
+        }
+      }
+    }
+  }
+
+  FFTPlan* plan_ = nullptr;  // shared tables and backend
+  bool bin_ranges_ready_ = false;
+  ma_uint32 sample_rate_ = 0;
+  std::array<BinRange, NumBins> bin_ranges_;
+
+  alignas(JUM_ALIGNMENT) std::array<float, FftSize> in_;
+  alignas(JUM_ALIGNMENT) std::array<float, FftSize> out_;
+  alignas(JUM_ALIGNMENT) std::array<float, FftSize> work_;
+  alignas(JUM_ALIGNMENT) std::array<float, FftSize / 2> magnitudes_;
+  std::array<float, NumBins> raw_;
+  std::array<float, NumBins> averaged_;
+  std::array<float, NumBins> result_;
+  float max_ = 2.5;
+  ma_int32 pos_ = 0;
+  ma_uint32 last_publish_ = 0;
+  float delay_ms_ = 0;
+};
+
+}  // namespace jum
+
+#endif  // JUMAUDIO_HPP_